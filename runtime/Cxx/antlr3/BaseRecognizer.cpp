@@ -58,7 +58,7 @@ RecognizerSharedState::~RecognizerSharedState()
 }
 
 BaseRecognizer::BaseRecognizer(RecognizerSharedStatePtr state)
-: state_(state ? state : std::make_shared<RecognizerSharedState>())
+: state_(state ? state : makeShared<RecognizerSharedState>())
     , debugger_()
     , input_()
     , filteringMode_(false)
@@ -110,11 +110,11 @@ bool BaseRecognizer::evalPredicate(bool result, const char * predicate)
 /// rule.  Rule would recover by resynchronizing to the set of
 /// symbols that can follow rule ref.
 ///
-ItemPtr BaseRecognizer::match(std::uint32_t ttype, Bitset const & follow)
+Item BaseRecognizer::match(std::uint32_t ttype, Bitset const & follow)
 {
     // Pick up the current input token/node for assignment to labels
     //
-    ItemPtr matchedSymbol = currentInputSymbol();
+    Item matchedSymbol = currentInputSymbol();
 
     if(input_->LA(1) == ttype)
     {
@@ -575,7 +575,7 @@ void BaseRecognizer::recover()
 /// sorted in the recognizer exception stack in the C version. To 'throw' it we set the
 /// error flag and rules cascade back when this is set.
 ///
-ItemPtr BaseRecognizer::recoverFromMismatchedToken(std::uint32_t ttype, Bitset const & follow)
+Item BaseRecognizer::recoverFromMismatchedToken(std::uint32_t ttype, Bitset const & follow)
 {
     // If the next token after the one we are looking at in the input stream
     // is what we are looking for then we remove the one we have discovered
@@ -599,7 +599,7 @@ ItemPtr BaseRecognizer::recoverFromMismatchedToken(std::uint32_t ttype, Bitset c
 
         // Return the token we are actually matching
         //
-        ItemPtr matchedSymbol = currentInputSymbol();
+        Item matchedSymbol = currentInputSymbol();
 
         // Consume the token that the rule actually expected to get as if everything
         // was hunky dory.
@@ -642,7 +642,7 @@ ItemPtr BaseRecognizer::recoverFromMismatchedToken(std::uint32_t ttype, Bitset c
     return nullptr;
 }
 
-ItemPtr BaseRecognizer::recoverFromMismatchedSet(Bitset const & follow)
+Item BaseRecognizer::recoverFromMismatchedSet(Bitset const & follow)
 {
     if	(mismatchIsMissingToken(follow) == true)
     {
@@ -671,7 +671,7 @@ ItemPtr BaseRecognizer::recoverFromMismatchedSet(Bitset const & follow)
     recordException(new MismatchedSetException(Bitset()));
     state_->error	= true;
     state_->failed	= true;
-    return NULL;
+    return nullptr;
 }
 
 /// This code is factored out from mismatched token and mismatched set
@@ -844,7 +844,7 @@ bool BaseRecognizer::synpred(void * ctx, void (*predicate)(void * ctx))
     /* Begin backtracking so we can get back to where we started after trying out
      * the syntactic predicate.
      */
-    MarkerPtr start = input_->mark();
+    Checkpoint start = input_->checkpoint();
     state_->backtracking++;
 
     /* Try the syntactical predicate
@@ -853,7 +853,7 @@ bool BaseRecognizer::synpred(void * ctx, void (*predicate)(void * ctx))
 
     /* Reset
      */
-    start->rewind();
+    input_->restore(start);
     state_->backtracking--;
 
     if	(state_->failed == true)
@@ -886,7 +886,7 @@ void BaseRecognizer::reset()
     state_->ruleMemo.clear();
 }
 
-ItemPtr BaseRecognizer::currentInputSymbol()
+Item BaseRecognizer::currentInputSymbol()
 {
     return input_->LI(1);
 }
@@ -931,9 +931,9 @@ static String getTokenErrorDisplay(std::uint32_t type, ConstString const * token
     return String(ANTLR3_T("<")) + getTokenName(type, tokenNames) + ANTLR3_T(">");
 }
 
-static String getTokenErrorDisplay(ItemPtr item, ConstString const * tokenNames)
+static String getTokenErrorDisplay(Item const & item, ConstString const * tokenNames)
 {
-    CommonTokenPtr t = std::static_pointer_cast<CommonToken>(item);
+    CommonTokenPtr t = pointer_cast<CommonTokenPtr>(item);
     if (t == nullptr)
     {
         assert(false);
@@ -71,7 +71,7 @@ public:
     /// exception pointer below (you can chain these if you like and handle them
     /// in some customized way).
     ///
-    ItemPtr match(std::uint32_t ttype, Bitset const & follow);
+    Item match(std::uint32_t ttype, Bitset const & follow);
 
     /// Function that matches the next token/char in the input stream
     /// regardless of what it actually is.
@@ -163,12 +163,12 @@ public:
     /// Pointer to a function that recovers from a mismatched token in the input stream.
     ///\see antlr3RecoverMismatch() for details.
     ///
-    ItemPtr recoverFromMismatchedToken(std::uint32_t ttype, Bitset const & follow);
+    Item recoverFromMismatchedToken(std::uint32_t ttype, Bitset const & follow);
 
     /// Pointer to a function that recovers from a mismatched set in the token stream, in a similar manner
     /// to recoverFromMismatchedToken
     ///
-    ItemPtr recoverFromMismatchedSet(Bitset const & follow);
+    Item recoverFromMismatchedSet(Bitset const & follow);
 
     /// Pointer to common routine to handle single token insertion for recovery functions.
     ///
@@ -211,7 +211,7 @@ public:
     /// This is ignored for lexers and the lexer implementation of this
     /// function should return NULL.
     ///
-    ItemPtr currentInputSymbol();
+    Item currentInputSymbol();
 
     /// Conjure up a missing token during error recovery.
     ///
@@ -286,7 +286,7 @@ protected:
     void recordException(std::unique_ptr<Exception> ex);
     void recordException(Exception* e);
     
-    virtual std::uint32_t itemToInt(ItemPtr item) = 0;
+    virtual std::uint32_t itemToInt(Item const & item) = 0;
 
     void followPush(Bitset const * data);
     void followPop();
@@ -47,10 +47,10 @@ namespace antlr3 {
 /// have payload itself), but non-null node is called ANTLR3_T("nil").
 ///
 template<class ChildT>
-class BaseTree : public std::enable_shared_from_this<ChildT>
+class BaseTree : public EnableSharedFromThis<ChildT>
 {
 protected:
-    typedef std::shared_ptr<ChildT> ChildPtr;
+    typedef SharedPtr<ChildT> ChildPtr;
     std::vector<ChildPtr> children_;
 public:
     BaseTree() {}
@@ -0,0 +1,113 @@
+/** \file
+ *  Implementation of the CharSet lookup tables.
+ */
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/CharSet.hpp>
+#include <algorithm>
+#include <map>
+
+namespace antlr3 {
+
+CharSet::CharSet()
+    : pages_()
+    , bits_(PageWords)
+    , large_()
+{
+}
+
+CharSet CharSet::fromRanges(std::initializer_list<std::uint32_t> bounds)
+{
+    assert(bounds.size() % 2 == 0);
+
+    // Set the bits of the whole first plane, then share equal pages
+    //
+    std::vector<std::uint64_t> plane(0x10000 / 64);
+    CharSet retVal;
+    for (auto it = bounds.begin(); it != bounds.end(); it += 2)
+    {
+        std::uint32_t low = it[0];
+        std::uint32_t high = it[1];
+        assert(low <= high);
+        for (std::uint32_t c = low; c <= high && c < 0x10000; ++c)
+        {
+            plane[c >> 6] |= std::uint64_t(1) << (c & 63);
+        }
+        if (high >= 0x10000)
+        {
+            retVal.large_.push_back(std::make_pair(std::max(low, std::uint32_t(0x10000)), high));
+        }
+    }
+
+    // Lookup relies on ranges being disjoint, so overlapping and adjacent ones are merged
+    //
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> & large = retVal.large_;
+    std::sort(large.begin(), large.end());
+    std::size_t merged = 0;
+    for (std::size_t i = 0; i < large.size(); ++i)
+    {
+        if (merged > 0 && large[i].first <= std::uint64_t(large[merged - 1].second) + 1)
+        {
+            large[merged - 1].second = std::max(large[merged - 1].second, large[i].second);
+        }
+        else
+        {
+            large[merged++] = large[i];
+        }
+    }
+    large.resize(merged);
+
+    std::map<std::vector<std::uint64_t>, std::uint16_t> distinct;
+    distinct[std::vector<std::uint64_t>(PageWords)] = 0;
+    for (std::size_t p = 0; p < 256; ++p)
+    {
+        std::vector<std::uint64_t> page(plane.begin() + p * PageWords, plane.begin() + (p + 1) * PageWords);
+        auto found = distinct.find(page);
+        if (found == distinct.end())
+        {
+            std::uint16_t index = std::uint16_t(distinct.size());
+            found = distinct.insert(std::make_pair(page, index)).first;
+            retVal.bits_.insert(retVal.bits_.end(), page.begin(), page.end());
+        }
+        retVal.pages_[p] = found->second;
+    }
+    return retVal;
+}
+
+bool CharSet::containsLarge(std::uint32_t c) const
+{
+    // First range that starts after c, the one before it may contain c
+    //
+    auto it = std::upper_bound(large_.begin(), large_.end(), std::make_pair(c, std::uint32_t(-1)));
+    return it != large_.begin() && c <= (it - 1)->second;
+}
+
+} // namespace antlr3
@@ -0,0 +1,83 @@
+/** \file
+ *  Defines a set of characters or token types with constant time membership test,
+ *  used by generated recognizers for sets too large to test range by range.
+ */
+#ifndef _ANTLR3_CHARSET_HPP
+#define _ANTLR3_CHARSET_HPP
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/Defs.hpp>
+#include <initializer_list>
+#include <utility>
+
+namespace antlr3 {
+
+/// Set of characters, or token types, stored as a two level table.
+///
+/// Values below 0x10000 are looked up in a bitmap of their 256-value page,
+/// found through a table indexed by the high byte; pages with the same contents
+/// share one bitmap, so sparse sets and sets of whole blocks stay small.
+/// Larger values, such as astral code points, are found by binary search over ranges.
+class CharSet
+{
+public:
+    /// Builds the set from inclusive ranges, given as consecutive low, high pairs.
+    static CharSet fromRanges(std::initializer_list<std::uint32_t> bounds);
+
+    CharSet();
+
+    bool contains(std::uint32_t c) const
+    {
+        if (c < 0x10000)
+        {
+            std::uint64_t const * page = &bits_[std::size_t(pages_[c >> 8]) * PageWords];
+            return ((page[(c >> 6) & (PageWords - 1)] >> (c & 63)) & 1) != 0;
+        }
+        return containsLarge(c);
+    }
+private:
+    static std::size_t const PageWords = 4;
+
+    /// Index of the bitmap of each page, in units of PageWords.
+    std::uint16_t pages_[256];
+
+    /// Distinct page bitmaps; the first one is empty.
+    std::vector<std::uint64_t> bits_;
+
+    /// Sorted, disjoint ranges of values from 0x10000 up.
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> large_;
+
+    bool containsLarge(std::uint32_t c) const;
+};
+
+} // namespace antlr3
+
+#endif
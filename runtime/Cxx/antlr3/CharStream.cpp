@@ -34,22 +34,34 @@
 #include <antlr3/CharStream.hpp>
 #include <antlr3/ConvertUTF.hpp>
 
-namespace antlr3 {
+#if defined(_WIN64) || defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-ItemPtr CharStream::itemFromChar(Char c) {
-    size_t n = static_cast<size_t>(c);
-    void* p = reinterpret_cast<void*>(n);
-    return ItemPtr(p, [](void*){});
-}
+namespace antlr3 {
 
-Char CharStream::charFromItem(ItemPtr const & item) {
-    size_t n = reinterpret_cast<size_t>(item.get());
-    return static_cast<Char>(n);
+Item CharStream::LI(std::int32_t i)
+{
+    return Item::fromChar(LA(i));
 }
 
-ItemPtr CharStream::LI(std::int32_t i)
+void CharStream::skipChars(AsciiSet const & set)
 {
-    return itemFromChar(LA(i));
+    while (set.contains(LA(1)))
+    {
+        consume();
+    }
 }
 
 template<class CodeUnit>
@@ -57,11 +69,18 @@ BasicCharStream<CodeUnit>::BasicCharStream(DataRef data, String name)
     : CharStream()
     , streamName_(std::move(name))
     , data_(std::move(data))
-    , lastPos_(data_.begin())
+    , lines_({0})
+    , scannedPos_(data_.begin())
+    , linesMutex_()
     , currentPos_(data_.begin())
-    , lines_({data_.begin()})
     , newlineChar_('\n')
+    , caseFolding_(CaseFolding::None)
+    , folded_()
+    , laBase_(data_.begin())
+    , foldedEnd_(data_.end())
 {
+    // Line offsets are 32-bit
+    assert(data_.size() <= 0xFFFFFFFF);
 }
 
 template<class CodeUnit>
@@ -78,16 +97,10 @@ String BasicCharStream<CodeUnit>::sourceName()
 template<class CodeUnit>
 void BasicCharStream<CodeUnit>::consume()
 {
+    // Lines are not tracked here, location() finds them when needed.
     if (currentPos_ != data_.end())
     {
-        std::uint32_t c = read(currentPos_);
         ++currentPos_;
-        if(currentPos_ > lastPos_) {
-            lastPos_ = currentPos_;
-            if (c == newlineChar_) {
-                lines_.push_back(currentPos_);
-            }
-        }
     }
 }
 
@@ -99,7 +112,7 @@ std::uint32_t BasicCharStream<CodeUnit>::LA(std::int32_t i)
         CodeUnit const * ptr = currentPos_ + (i - 1);
         if (ptr < data_.end())
         {
-            return read(ptr);
+            return readLA(ptr);
         }
         return CharstreamEof;
     }
@@ -108,7 +121,7 @@ std::uint32_t BasicCharStream<CodeUnit>::LA(std::int32_t i)
         CodeUnit const * ptr = currentPos_ + i;
         if (ptr >= data_.begin())
         {
-            return read(ptr);
+            return readLA(ptr);
         }
         return CharstreamEof;
     }
@@ -122,7 +135,7 @@ std::uint32_t BasicCharStream<CodeUnit>::LA(std::int32_t i)
 template<class CodeUnit>
 MarkerPtr BasicCharStream<CodeUnit>::mark()
 {
-    return std::make_shared<CharStreamMarker>(currentPos_, this->shared_from_this());
+    return makeShared<CharStreamMarker>(currentPos_, this->shared_from_this());
 }
 
 template<class CodeUnit>
@@ -134,16 +147,50 @@ Index BasicCharStream<CodeUnit>::index()
 template<class CodeUnit>
 void BasicCharStream<CodeUnit>::seek(Index index)
 {
-    assert(index >= BasicCharStream<CodeUnit>::index());
-    auto p = data_.begin() + index;
-    currentPos_ = std::min(lastPos_, p);
-    while (currentPos_ < p) {
-        consume();
-    }
+    currentPos_ = data_.begin() + std::min(index, data_.size());
 }
 
 // CharStream
 
+namespace {
+
+template<class CodeUnit>
+CodeUnit const * findNewline(CodeUnit const * begin, CodeUnit const * end, std::uint8_t newlineChar)
+{
+    return std::find(begin, end, CodeUnit(newlineChar));
+}
+
+// memchr() is vectorized by the C library
+inline std::uint8_t const * findNewline(std::uint8_t const * begin, std::uint8_t const * end, std::uint8_t newlineChar)
+{
+    void const * p = memchr(begin, newlineChar, end - begin);
+    return p ? static_cast<std::uint8_t const *>(p) : end;
+}
+
+inline char const * findNewline(char const * begin, char const * end, std::uint8_t newlineChar)
+{
+    void const * p = memchr(begin, newlineChar, end - begin);
+    return p ? static_cast<char const *>(p) : end;
+}
+
+} // namespace
+
+template<class CodeUnit>
+void BasicCharStream<CodeUnit>::scanLines(CodeUnit const * ptr)
+{
+    while (scannedPos_ < ptr)
+    {
+        CodeUnit const * nl = findNewline(scannedPos_, ptr, newlineChar_);
+        if (nl == ptr)
+        {
+            break;
+        }
+        lines_.push_back(std::uint32_t(nl + 1 - data_.begin()));
+        scannedPos_ = nl + 1;
+    }
+    scannedPos_ = std::max(scannedPos_, ptr);
+}
+
 template<class CodeUnit>
 Location BasicCharStream<CodeUnit>::location(Index index)
 {
@@ -152,22 +199,17 @@ Location BasicCharStream<CodeUnit>::location(Index index)
         assert(false);
         return location(data_.end() - data_.begin());
     }
-    if (ptr > lastPos_) {
-        assert(false && "Should not access locations in not read area");
-        auto tmp = currentPos_;
-        currentPos_ = lastPos_;
-        while (lastPos_ < ptr) {
-            consume();
-        }
-        currentPos_ = tmp;
-    }
-    auto it = std::lower_bound(lines_.begin(), lines_.end(), ptr);
-    if (it == lines_.end() || *it > ptr) {
-        assert(it > lines_.begin());
-        --it;
-    }
+
+#if !ANTLR3_SINGLE_THREADED
+    std::lock_guard<std::mutex> lock(linesMutex_);
+#endif
+    scanLines(ptr);
+
+    auto it = std::upper_bound(lines_.begin(), lines_.end(), std::uint32_t(index));
+    assert(it > lines_.begin());
+    --it;
     size_t line = it - lines_.begin();
-    size_t charPos = ptr - *it;
+    size_t charPos = index - *it;
     return Location(std::uint32_t(1 + line), std::uint32_t(1 + charPos));
 }
 
@@ -179,6 +221,91 @@ String BasicCharStream<CodeUnit>::substr(Index start, Index stop)
     return String(b, e);
 }
 
+namespace {
+
+/// Code units can be viewed as String only if they have the same size.
+template<class CodeUnit>
+StringView makeView(CodeUnit const * b, CodeUnit const * e, std::true_type)
+{
+    return StringView(reinterpret_cast<String::value_type const *>(b), e - b);
+}
+
+template<class CodeUnit>
+StringView makeView(CodeUnit const *, CodeUnit const *, std::false_type)
+{
+    return StringView();
+}
+
+} // namespace
+
+template<class CodeUnit>
+StringView BasicCharStream<CodeUnit>::textView(Index start, Index stop)
+{
+    typedef std::integral_constant<bool, sizeof(CodeUnit) == sizeof(String::value_type)> SameSize;
+    return makeView(data_.begin() + start, data_.begin() + stop, SameSize());
+}
+
+template<class CodeUnit>
+void BasicCharStream<CodeUnit>::skipChars(AsciiSet const & set)
+{
+    // Code units of a character outside ASCII are all outside ASCII too,
+    // so the scan either steps over all of them or stops at the first one.
+    CodeUnit const * ptr = currentPos_;
+    CodeUnit const * end = data_.end();
+    while (ptr != end && set.contains(readLA(ptr)))
+    {
+        ++ptr;
+    }
+    currentPos_ = ptr;
+}
+
+template<class CodeUnit>
+void BasicCharStream<CodeUnit>::setCaseFolding(CaseFolding folding)
+{
+    caseFolding_ = folding;
+    if (folding == CaseFolding::None)
+    {
+        folded_.reset();
+        laBase_ = data_.begin();
+        foldedEnd_ = data_.end();
+    }
+    else
+    {
+        folded_.reset(new CodeUnit[data_.size()]);
+        laBase_ = folded_.get();
+        foldedEnd_ = data_.begin();
+    }
+}
+
+template<class CodeUnit>
+void BasicCharStream<CodeUnit>::foldThrough(CodeUnit const * ptr)
+{
+    // Fold a block at a time, so that readLA() rarely gets here
+    //
+    std::size_t const FoldBlock = 4096;
+    std::size_t from = foldedEnd_ - data_.begin();
+    std::size_t to = std::max<std::size_t>(ptr - data_.begin() + 1, from + FoldBlock);
+    to = std::min<std::size_t>(to, data_.size());
+
+    CodeUnit const * in = data_.begin();
+    CodeUnit * out = folded_.get();
+    if (caseFolding_ == CaseFolding::Upper)
+    {
+        for (std::size_t i = from; i < to; ++i)
+        {
+            out[i] = in[i] >= 'a' && in[i] <= 'z' ? CodeUnit(in[i] - ('a' - 'A')) : in[i];
+        }
+    }
+    else
+    {
+        for (std::size_t i = from; i < to; ++i)
+        {
+            out[i] = in[i] >= 'A' && in[i] <= 'Z' ? CodeUnit(in[i] + ('a' - 'A')) : in[i];
+        }
+    }
+    foldedEnd_ = in + to;
+}
+
 template<class CodeUnit>
 void BasicCharStream<CodeUnit>::reset()
 {
@@ -200,9 +327,17 @@ std::uint8_t BasicCharStream<CodeUnit>::newLineChar() const
 template<class CodeUnit>
 void BasicCharStream<CodeUnit>::setNewLineChar(std::uint8_t newLineChar)
 {
+#if !ANTLR3_SINGLE_THREADED
+    std::lock_guard<std::mutex> lock(linesMutex_);
+#endif
     newlineChar_ = newLineChar;
+    lines_.assign(1, 0);
+    scannedPos_ = data_.begin();
 }
 
+template class BasicCharStream<std::uint8_t>;
+template class BasicCharStream<String::value_type>;
+
 ByteCharStream::ByteCharStream(DataRef data, String name)
     : BasicCharStream(std::move(data), std::move(name))
 {}
@@ -217,10 +352,218 @@ ByteCharStream::ByteCharStream(void const * data, std::uint32_t size, Deleter de
 
 ByteCharStream::~ByteCharStream() {}
 
+#if defined(_WIN64) || defined(_WIN32)
+
+ByteCharStream::DataRef ByteCharStream::mapFile(char const * fileName)
+{
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return DataRef();
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart > 0xFFFFFFFF) {
+        CloseHandle(file);
+        return DataRef();
+    }
+
+    std::size_t size = std::size_t(fileSize.QuadPart);
+    if (size == 0) {
+        // Empty files cannot be mapped
+        CloseHandle(file);
+        static std::uint8_t const empty[1] = { 0 };
+        return DataRef(empty, std::size_t(0), [](std::uint8_t const *) {});
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return DataRef();
+    }
+
+    void const * addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    // View keeps the mapping object alive
+    CloseHandle(mapping);
+    if (addr == NULL) {
+        return DataRef();
+    }
+
+    return DataRef(reinterpret_cast<std::uint8_t const *>(addr), size, [](std::uint8_t const * d) {
+        UnmapViewOfFile(d);
+    });
+}
+
+#else
+
+ByteCharStream::DataRef ByteCharStream::mapFile(char const * fileName)
+{
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return DataRef();
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || std::uint64_t(st.st_size) > 0xFFFFFFFF) {
+        ::close(fd);
+        return DataRef();
+    }
+
+    std::size_t size = std::size_t(st.st_size);
+    if (size == 0) {
+        // mmap() refuses zero length
+        ::close(fd);
+        static std::uint8_t const empty[1] = { 0 };
+        return DataRef(empty, std::size_t(0), [](std::uint8_t const *) {});
+    }
+
+    void * addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // Mapping stays valid after descriptor is closed
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return DataRef();
+    }
+
+    // Lexers read input front to back, so let the kernel read ahead aggressively.
+    // This is only a hint, failure is not an error.
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+
+    return DataRef(reinterpret_cast<std::uint8_t const *>(addr), size, [size](std::uint8_t const * d) {
+        ::munmap(const_cast<std::uint8_t *>(d), size);
+    });
+}
+
+#endif
+
+UTF8CharStream::UTF8CharStream(DataRef data, String name)
+    : BasicCharStream(std::move(data), std::move(name))
+{}
+
+UTF8CharStream::UTF8CharStream(void const * data, std::uint32_t size, String name)
+    : BasicCharStream(DataRef(reinterpret_cast<std::uint8_t const *>(data), size), std::move(name))
+{}
+
+UTF8CharStream::UTF8CharStream(void const * data, std::uint32_t size, Deleter deleter, String name)
+    : BasicCharStream(DataRef(reinterpret_cast<std::uint8_t const *>(data), size, deleter), std::move(name))
+{}
+
+UTF8CharStream::~UTF8CharStream() {}
+
+std::uint8_t const * UTF8CharStream::next(std::uint8_t const * ptr, std::uint32_t & ch) const
+{
+    if (*ptr < 0x80) {
+        ch = *ptr;
+        return ptr + 1;
+    }
+
+    std::uint8_t const * p = ptr;
+    utf::ConversionResult r = utf::Traits<utf::UTF8>::Read(p, data_.end(), ch, utf::ConversionFlags::LenientConversion);
+    if (r != utf::ConversionResult::ConversionOK) {
+        // Truncated or malformed tail is a single replacement character, as in UnicodeCharStream
+        ch = utf::UNI_REPLACEMENT_CHAR;
+        return data_.end();
+    }
+    return p;
+}
+
+std::uint8_t const * UTF8CharStream::prev(std::uint8_t const * ptr) const
+{
+    std::uint8_t const * q = ptr - 1;
+    while (q > data_.begin() && ptr - q < 4 && (*q & 0xC0) == 0x80) {
+        --q;
+    }
+    std::uint32_t ch;
+    if (next(q, ch) == ptr) {
+        return q;
+    }
+    // Not a well-formed sequence, step over a single byte
+    return ptr - 1;
+}
+
+void UTF8CharStream::consume()
+{
+    if (currentPos_ != data_.end())
+    {
+        std::uint32_t ch;
+        currentPos_ = next(currentPos_, ch);
+    }
+}
+
+std::uint32_t UTF8CharStream::LA(std::int32_t i)
+{
+    if (i > 0)
+    {
+        std::uint8_t const * ptr = currentPos_;
+        std::uint8_t const * start = ptr;
+        std::uint32_t ch = CharstreamEof;
+        for (; i > 0; --i) {
+            if (ptr == data_.end()) {
+                return CharstreamEof;
+            }
+            start = ptr;
+            ptr = next(ptr, ch);
+        }
+        // Only ASCII letters are folded
+        return ch < 0x80 ? readLA(start) : ch;
+    }
+    else if (i < 0)
+    {
+        std::uint8_t const * ptr = currentPos_;
+        for (; i < 0; ++i) {
+            if (ptr == data_.begin()) {
+                return CharstreamEof;
+            }
+            ptr = prev(ptr);
+        }
+        std::uint32_t ch;
+        next(ptr, ch);
+        return ch < 0x80 ? readLA(ptr) : ch;
+    }
+    else
+    {
+        assert(false);
+        return CharstreamEof;
+    }
+}
+
+Location UTF8CharStream::location(Index index)
+{
+    Location loc = BasicCharStream::location(index);
+    if (!loc.isValid()) {
+        return loc;
+    }
+
+    // Base class counts columns in bytes, recount them in code points
+    std::uint8_t const * ptr = data_.begin() + std::min(index, data_.size());
+    std::uint8_t const * lineStart = ptr - (loc.charPositionInLine() - 1);
+    std::uint32_t column = 1;
+    for (std::uint8_t const * p = lineStart; p < ptr; ++p) {
+        if ((*p & 0xC0) != 0x80) {
+            ++column;
+        }
+    }
+    return Location(loc.line(), column);
+}
+
+String UTF8CharStream::substr(Index start, Index stop)
+{
+#if ANTLR3_UTF16
+    String retVal;
+    appendUTF8(retVal, std::string(data_.begin() + start, data_.begin() + stop));
+    return retVal;
+#else
+    return BasicCharStream::substr(start, stop);
+#endif
+}
+
 UnicodeCharStream::UnicodeCharStream(void const * data, std::uint32_t size, String name, TextEncoding encoding)
     : BasicCharStream(decodeData(data, size, encoding), std::move(name))
 {}
 
+UnicodeCharStream::UnicodeCharStream(ByteCharStream::DataRef const & data, String name, TextEncoding encoding)
+    : BasicCharStream(decodeData(data.begin(), (std::uint32_t)data.size(), encoding), std::move(name))
+{}
+
 UnicodeCharStream::~UnicodeCharStream() {}
 
 UnicodeCharStream::DataRef UnicodeCharStream::decodeData(void const * data, std::uint32_t size, TextEncoding encoding)
@@ -242,6 +585,33 @@ UnicodeCharStream::DataRef UnicodeCharStream::decodeData(void const * data, std:
     }
 }
     
+namespace {
+
+/// Converts code units stored in the given byte order.
+template<class UTF, class ByteOrder>
+struct Decoder
+{
+    template<class DestUTF, class OutIterator>
+    static utf::ConversionResult convert(std::uint8_t const * dataStart, std::uint8_t const * dataEnd, OutIterator& begin, OutIterator end)
+    {
+        utf::CodeUnitIterator<std::uint8_t const *, UTF, ByteOrder> srcStart(dataStart), srcEnd(dataEnd);
+        return utf::Convert<UTF, DestUTF>(srcStart, srcEnd, begin, end, utf::ConversionFlags::LenientConversion);
+    }
+};
+
+/// UTF-8 has no byte order, so the buffer is converted directly with ASCII runs copied in bulk.
+template<class ByteOrder>
+struct Decoder<utf::UTF8, ByteOrder>
+{
+    template<class DestUTF, class OutIterator>
+    static utf::ConversionResult convert(std::uint8_t const * dataStart, std::uint8_t const * dataEnd, OutIterator& begin, OutIterator end)
+    {
+        return utf::ConvertBuffer<utf::UTF8, DestUTF>(dataStart, dataEnd, begin, end, utf::ConversionFlags::LenientConversion);
+    }
+};
+
+} // namespace
+
 template<class UTF, class ByteOrder, class OutIterator>
 void UnicodeCharStream::decode(void const * data, std::uint32_t size, OutIterator& begin, OutIterator end)
 {
@@ -251,8 +621,7 @@ void UnicodeCharStream::decode(void const * data, std::uint32_t size, OutIterato
     
     typedef utf::CodeUnitForChar<CharType>::type DestUTF;
     
-    utf::CodeUnitIterator<decltype(dataStart), UTF, ByteOrder> srcStart(dataStart), srcEnd(dataEnd);
-    utf::ConversionResult r = utf::Convert<UTF, DestUTF>(srcStart, srcEnd, begin, end, utf::ConversionFlags::LenientConversion);
+    utf::ConversionResult r = Decoder<UTF, ByteOrder>::template convert<DestUTF>(dataStart, dataEnd, begin, end);
     assert(r == utf::ConversionResult::ConversionOK || r == utf::ConversionResult::SourceExhausted);
     if (r == utf::ConversionResult::SourceExhausted || k > 0) {
         r = utf::Traits<DestUTF>::Write(begin, end, utf::UNI_REPLACEMENT_CHAR);
@@ -264,11 +633,35 @@ template<class UTF, class ByteOrder>
 UnicodeCharStream::DataRef UnicodeCharStream::decode(void const * data, std::uint32_t size)
 {
     typedef utf::CodeUnitForChar<CharType>::type DestUTF;
+    Deleter del = [](CharType const * d) { delete[] d; };
+
+    if (sizeof(DestUTF) > 1 && sizeof(DestUTF) >= sizeof(UTF))
+    {
+        // Every source code unit produces at most one destination code unit
+        // (this does not hold for UTF-8 output, where a replacement character takes 3 bytes),
+        // plus one replacement character for a truncated tail.
+        // So decode in a single pass into a buffer of the source length.
+        std::size_t capacity = size / sizeof(UTF) + 1;
+        CharType * ptr = new CharType[capacity];
+        CharType * ptrEnd = ptr;
+        decode<UTF, ByteOrder>(data, size, ptrEnd, ptr + capacity);
+        std::size_t len = ptrEnd - ptr;
+
+        if (len < capacity - capacity / 4)
+        {
+            // Mostly multi-unit characters, do not keep the slack around.
+            CharType * exact = new CharType[len];
+            std::copy(ptr, ptrEnd, exact);
+            delete[] ptr;
+            ptr = exact;
+        }
+        return DataRef(ptr, len, std::move(del));
+    }
+
     utf::DummyWriteIterator<DestUTF> lenStart(0), lenEnd;
     decode<UTF, ByteOrder>(data, size, lenStart, lenEnd);
 
     std::size_t len = lenStart.pos();
-    Deleter del = [](CharType const * d) { delete[] d; };
     CharType * ptr = new CharType[len];
     DataRef retVal(ptr, len, std::move(del));
     decode<UTF, ByteOrder>(data, size, ptr, ptr + len);
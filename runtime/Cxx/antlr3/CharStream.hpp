@@ -44,24 +44,124 @@
 #include <antlr3/Location.hpp>
 #include <type_traits>
 #include <cstring>
+#include <mutex>
 
 namespace antlr3 {
 
+/// Set of characters, which character streams can skip without decoding input.
+/// It holds any subset of ASCII, and optionally all non-ASCII characters as a whole.
+class AsciiSet
+{
+public:
+    AsciiSet() : bits_(), nonAscii_() {}
+
+    AsciiSet & add(std::uint32_t c)
+    {
+        return add(c, c);
+    }
+
+    AsciiSet & add(std::uint32_t low, std::uint32_t high)
+    {
+        assert(low <= high && high < 128);
+        for (std::uint32_t c = low; c <= high; ++c)
+        {
+            bits_[c >> 6] |= std::uint64_t(1) << (c & 63);
+        }
+        return *this;
+    }
+
+    /// Adds every character above ASCII.
+    AsciiSet & addNonAscii()
+    {
+        nonAscii_ = true;
+        return *this;
+    }
+
+    bool contains(std::uint32_t c) const
+    {
+        if (c < 128)
+        {
+            return ((bits_[c >> 6] >> (c & 63)) & 1) != 0;
+        }
+        return nonAscii_ && c != CharstreamEof;
+    }
+
+    bool empty() const { return bits_[0] == 0 && bits_[1] == 0 && !nonAscii_; }
+private:
+    std::uint64_t bits_[2];
+    bool nonAscii_;
+};
+
+/// How a case-insensitive stream folds letters for LA().
+enum class CaseFolding
+{
+    None,
+    Upper,
+    Lower
+};
+
+/// Same as equalsAscii(s, ascii, size), but compares \a s as LA() of a stream folding with
+/// \a folding sees it. Token text keeps the original spelling, while keywords are spelled
+/// in the folded case.
+inline bool equalsAscii(StringView s, char const * ascii, std::size_t size, CaseFolding folding)
+{
+    if (folding == CaseFolding::None)
+    {
+        return equalsAscii(s, ascii, size);
+    }
+    if (s.size() != size)
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        StringView::value_type c = s[i];
+        if (folding == CaseFolding::Upper ? c >= 'a' && c <= 'z' : c >= 'A' && c <= 'Z')
+        {
+            c = StringView::value_type(folding == CaseFolding::Upper ? c - ('a' - 'A') : c + ('a' - 'A'));
+        }
+        if (c != StringView::value_type(ascii[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 class CharStream : public IntStream, public LocationSource
 {
 public:
-    static ItemPtr itemFromChar(Char c);
-    static Char charFromItem(ItemPtr const & item);
+    static Item itemFromChar(Char c) { return Item::fromChar(c); }
+    static Char charFromItem(Item const & item) { return item.toChar(); }
     
-    virtual ItemPtr LI(std::int32_t i) override;
+    virtual Item LI(std::int32_t i) override;
 
     /// Returns the line number of the current position in the input stream.
     /// Interpretation of line number is determined by the stream itself.
     virtual Location currentLocation() { return location(index()); }
+
+    /// Returns true if substr() keeps working for already consumed input.
+    /// Streams that discard consumed input return false, and lexer copies token text
+    /// into tokens while it is still available.
+    virtual bool retainsInput() { return true; }
+
+    /// If the next \a len characters are the code units of \a string, consumes them
+    /// all at once and returns true. Returns false without consuming anything if they
+    /// differ, or if the stream cannot compare its buffer directly; the lexer then
+    /// matches the literal one character at a time and reports the mismatch.
+    virtual bool consumeLiteral(char const *, std::size_t) { return false; }
+    virtual bool consumeLiteral(char16_t const *, std::size_t) { return false; }
+    virtual bool consumeLiteral(char32_t const *, std::size_t) { return false; }
+
+    /// Consumes characters while they belong to \a set.
+    virtual void skipChars(AsciiSet const & set);
+
+    /// Returns how LA() folds letters; substr() and textView() are not folded.
+    virtual CaseFolding caseFolding() const { return CaseFolding::None; }
 };
 
 template<class CodeUnit>
-class BasicCharStream : public CharStream, public std::enable_shared_from_this<BasicCharStream<CodeUnit>>
+class BasicCharStream : public CharStream, public EnableSharedFromThis<BasicCharStream<CodeUnit>>
 {
 public:
     typedef std::function<void(CodeUnit const *)> Deleter;
@@ -74,7 +174,7 @@ public:
         {
             Deleter del = [](CodeUnit const * d) { delete[] d; };
             ptr_ = decltype(ptr_)(new CodeUnit[size], std::move(del));
-            memcpy(const_cast<CodeUnit*>(ptr_.get()), data, size);
+            memcpy(const_cast<CodeUnit*>(ptr_.get()), data, size * sizeof(CodeUnit));
             end_ = ptr_.get() + size;
         }
 
@@ -90,6 +190,9 @@ public:
         CodeUnit const * begin() const { return ptr_.get(); }
         CodeUnit const * end() const { return end_; }
         size_t size() const { return end_ - ptr_.get(); }
+
+        /// Returns false for default-constructed reference, or if data could not be obtained.
+        explicit operator bool() const { return ptr_ != nullptr; }
     private:
         std::unique_ptr<CodeUnit const [], Deleter> ptr_;
         CodeUnit const * end_;
@@ -104,6 +207,8 @@ public:
     virtual void consume() override;
     virtual std::uint32_t LA(std::int32_t i) override;
     virtual MarkerPtr mark() override;
+    virtual Checkpoint checkpoint() override { return Checkpoint(index()); }
+    virtual void restore(Checkpoint const & cp) override { seek(cp.index()); }
     virtual Index index() override;
     virtual void seek(Index index) override;
 
@@ -111,12 +216,37 @@ public:
 
     virtual Location location(Index index) override;
     virtual String substr(Index start, Index stop) override;
+    virtual StringView textView(Index start, Index stop) override;
+    virtual bool consumeLiteral(char const * string, std::size_t len) override { return consumeUnits(string, len); }
+    virtual bool consumeLiteral(char16_t const * string, std::size_t len) override { return consumeUnits(string, len); }
+    virtual bool consumeLiteral(char32_t const * string, std::size_t len) override { return consumeUnits(string, len); }
+    virtual void skipChars(AsciiSet const & set) override;
 
     /// Resets the input stream to start reading from the begining.
     void reset();
 
     std::uint32_t size();
 
+    /// Returns pointer to the first code unit of the input.
+    CodeUnit const * data() const { return data_.begin(); }
+
+    /// Same as LA(i) for i > 0, but not virtual, so that lexers bound to the stream
+    /// type can have it inlined. Streams that decode input hide it with their own.
+    std::uint32_t peek(std::int32_t i)
+    {
+        CodeUnit const * ptr = currentPos_ + (i - 1);
+        return ptr < data_.end() ? readLA(ptr) : CharstreamEof;
+    }
+
+    /// Same as consume(), but not virtual.
+    void advance()
+    {
+        if (currentPos_ != data_.end())
+        {
+            ++currentPos_;
+        }
+    }
+
     /// Returns character that triggers line number increment.
     /// By default it is '\n'.
     /// If for some reason you do not want the counters and pointers to be restee, you can set the 
@@ -124,11 +254,18 @@ public:
     /// This is a single character only, so choose the last character in a sequence of two or more.
     std::uint8_t newLineChar() const;
     void setNewLineChar(std::uint8_t newlineChar);
-private:
+
+    /// Makes the stream case-insensitive: LA(), peek() and literal matching see ASCII
+    /// letters folded to one case, so grammars spell keywords in that case only.
+    /// substr(), textView() and token text keep the original spelling.
+    /// Folded input is kept in a shadow buffer, filled ahead of reading as needed.
+    void setCaseFolding(CaseFolding folding);
+    virtual CaseFolding caseFolding() const override { return caseFolding_; }
+protected:
     class CharStreamMarker : public Marker
     {
     public:
-        CharStreamMarker(CodeUnit const * pos, std::shared_ptr<BasicCharStream<CodeUnit>> stream)
+        CharStreamMarker(CodeUnit const * pos, SharedPtr<BasicCharStream<CodeUnit>> stream)
             : Marker()
             , pos_(pos)
             , stream_(stream)
@@ -137,10 +274,9 @@ private:
         ~CharStreamMarker() {}
         
         CodeUnit const * pos_;
-        std::shared_ptr<BasicCharStream<CodeUnit>> stream_;
+        SharedPtr<BasicCharStream<CodeUnit>> stream_;
         
         virtual void rewind() {
-            assert(pos_ <= stream_->lastPos_);
             stream_->currentPos_ = pos_;
         }
     };
@@ -151,14 +287,17 @@ private:
     /// Smart pointer to the input buffer slice.
     DataRef data_;
 
-    /** List of start of line offsets
-     */
-    std::vector<CodeUnit const *> lines_;
+    /// Offsets of line starts found so far, computed lazily by location().
+    std::vector<std::uint32_t> lines_;
     
-    /// Current position
-    CodeUnit const * lastPos_;
+    /// Position up to which input has been scanned for line starts.
+    CodeUnit const * scannedPos_;
+
+    /// Guards lines_ and scannedPos_. Tokens look up their locations on
+    /// the parser thread while the lexer may do the same for errors.
+    std::mutex linesMutex_;
     
-    /// Last reached position
+    /// Current position
     CodeUnit const * currentPos_;
     
     /// Character that automatically causes an internal line count
@@ -166,10 +305,76 @@ private:
     ///
     std::uint8_t newlineChar_;
 
+    CaseFolding caseFolding_;
+
+    /// Case-folded copy of the input, valid below foldedEnd_.
+    std::unique_ptr<CodeUnit[]> folded_;
+
+    /// Input that LA() reads: the folded copy, or the input itself.
+    CodeUnit const * laBase_;
+
+    /// Position in the input up to which folded_ is filled;
+    /// end of input if the stream is not case-insensitive.
+    CodeUnit const * foldedEnd_;
+
+    /// Extends lines_ with line starts up to and including \a ptr.
+    void scanLines(CodeUnit const * ptr);
+
+    /// Fills folded_ up to and including \a ptr, and some more ahead of it.
+    void foldThrough(CodeUnit const * ptr);
+
+    /// Reads the code unit at \a ptr as LA() sees it.
+    std::uint32_t readLA(CodeUnit const * ptr)
+    {
+        if (ptr >= foldedEnd_)
+        {
+            foldThrough(ptr);
+        }
+        return read(laBase_ + (ptr - data_.begin()));
+    }
+
     static std::uint32_t read(CodeUnit const * ptr)
     {
         return std::uint32_t(typename std::make_unsigned<CodeUnit>::type(*ptr));
     }
+
+    /// Compares code units at the current position with \a string, as LA() would
+    /// see them, and skips them if they are equal.
+    template<class T>
+    bool consumeUnits(T const * string, std::size_t len)
+    {
+        if (std::size_t(data_.end() - currentPos_) < len)
+        {
+            return false;
+        }
+        if (len == 0)
+        {
+            return true;
+        }
+        if (currentPos_ + (len - 1) >= foldedEnd_)
+        {
+            foldThrough(currentPos_ + (len - 1));
+        }
+        if (sizeof(T) == sizeof(CodeUnit))
+        {
+            if (memcmp(laBase_ + (currentPos_ - data_.begin()), string, len * sizeof(T)) != 0)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < len; ++i)
+            {
+                if (readLA(currentPos_ + i) != std::uint32_t(typename std::make_unsigned<T>::type(string[i])))
+                {
+                    return false;
+                }
+            }
+        }
+        currentPos_ += len;
+        return true;
+    }
 };
 
 class ByteCharStream : public BasicCharStream<std::uint8_t>
@@ -179,6 +384,91 @@ public:
     ByteCharStream(void const * data, std::uint32_t size, String name);
     ByteCharStream(void const * data, std::uint32_t size, Deleter deleter, String name);
     ~ByteCharStream();
+
+    /// Maps the file read-only into memory, without copying its contents.
+    /// The mapping is released by the deleter of the returned DataRef, so the file stays mapped
+    /// for as long as any stream holds it. Pages are shared with the OS file cache,
+    /// and thus with other processes reading the same file.
+    ///
+    /// Returns null DataRef if the file cannot be opened or mapped.
+    static DataRef mapFile(char const * fileName);
+};
+
+/// Character stream over UTF-8 encoded input that decodes code points on the fly.
+///
+/// Unlike UnicodeCharStream, the input is kept as is, without converting it into String code units
+/// up front. LA() returns Unicode code points, while index() and token boundaries are byte offsets
+/// into the original buffer. Malformed sequences are read as U+FFFD, same as UnicodeCharStream does.
+/// Column numbers reported by location() are counted in code points.
+class UTF8CharStream : public BasicCharStream<std::uint8_t>
+{
+public:
+    UTF8CharStream(DataRef data, String name);
+    UTF8CharStream(void const * data, std::uint32_t size, String name);
+    UTF8CharStream(void const * data, std::uint32_t size, Deleter deleter, String name);
+    ~UTF8CharStream();
+
+    // IntStream
+
+    virtual void consume() override;
+    virtual std::uint32_t LA(std::int32_t i) override;
+
+    // CharStream
+
+    virtual Location location(Index index) override;
+    virtual String substr(Index start, Index stop) override;
+
+    /// UTF-8 literals are compared byte by byte, wider ones only if they are ASCII,
+    /// since LA() returns decoded code points.
+    using BasicCharStream<std::uint8_t>::consumeLiteral;
+    virtual bool consumeLiteral(char16_t const * string, std::size_t len) override
+    {
+        return isAscii(string, len) && consumeUnits(string, len);
+    }
+    virtual bool consumeLiteral(char32_t const * string, std::size_t len) override
+    {
+        return isAscii(string, len) && consumeUnits(string, len);
+    }
+
+    /// Non-virtual LA(i) for i > 0, ASCII characters are read without decoding.
+    std::uint32_t peek(std::int32_t i)
+    {
+        if (i == 1 && currentPos_ != data_.end() && *currentPos_ < 0x80)
+        {
+            return readLA(currentPos_);
+        }
+        return UTF8CharStream::LA(i);
+    }
+
+    /// Non-virtual consume(), ASCII characters are skipped without decoding.
+    void advance()
+    {
+        if (currentPos_ != data_.end() && *currentPos_ < 0x80)
+        {
+            ++currentPos_;
+            return;
+        }
+        UTF8CharStream::consume();
+    }
+private:
+    /// Decodes character starting at \a ptr and returns pointer to the next one.
+    std::uint8_t const * next(std::uint8_t const * ptr, std::uint32_t & ch) const;
+
+    /// Returns pointer to the start of the character preceding \a ptr.
+    std::uint8_t const * prev(std::uint8_t const * ptr) const;
+
+    template<class T>
+    static bool isAscii(T const * string, std::size_t len)
+    {
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            if (string[i] >= 0x80)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
 };
 
 class UnicodeCharStream : public BasicCharStream<String::value_type>
@@ -192,6 +482,10 @@ class UnicodeCharStream : public BasicCharStream<String::value_type>
     static void decode(void const * data, std::uint32_t size, OutIterator& begin, OutIterator end);
 public:
     UnicodeCharStream(void const * data, std::uint32_t size, String name, TextEncoding encoding);
+
+    /// Decodes the bytes held by \a data, which can be released right after construction.
+    /// Use together with ByteCharStream::mapFile() to decode files without intermediate copy.
+    UnicodeCharStream(ByteCharStream::DataRef const & data, String name, TextEncoding encoding);
     ~UnicodeCharStream();
 };
 
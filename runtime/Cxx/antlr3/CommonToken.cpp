@@ -90,6 +90,26 @@ String CommonToken::text() const
     return String();
 }
 
+StringView CommonToken::textView() const
+{
+    if(hasText_)
+    {
+        return StringView(tokText_);
+    }
+
+    if(type_ == TokenEof)
+    {
+        return StringView(ANTLR3_T("<EOF>"), 5);
+    }
+
+    if(input_ != NULL)
+    {
+        return input_->textView(startIndex(), stopIndex());
+    }
+
+    return StringView(tokText_);
+}
+
 /** \brief Install the supplied text string as teh text for the token.
  * The method assumes that the existing text (if any) was created by a factory
  * and so does not attempt to release any memory it is using.Text not created
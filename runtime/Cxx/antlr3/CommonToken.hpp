@@ -117,9 +117,17 @@ public:
     /// Use toString() if you want a printable representation of the token for debug purposes.
     String text() const;
 
+    /// Returns the text of a token without copying it.
+    /// The view refers to the overridden text or to the input buffer,
+    /// and is null if the input stream cannot provide it; use text() then.
+    StringView textView() const;
+
     /// Overrides text associated with a token.
     void setText(String text);
 
+    /// Returns true if text was overridden by setText().
+    bool hasText() const { return hasText_; }
+
     /// Token type of this token
     std::uint32_t type() const;
     void setType(std::uint32_t ttype);
@@ -112,7 +112,7 @@ void CommonTree::setTokenStopIndex(Index index)
 
 CommonTreePtr CommonTree::dupNode()
 {
-    return std::make_shared<CommonTree>(*this);
+    return makeShared<CommonTree>(*this);
 }
 
 bool CommonTree::isNil()
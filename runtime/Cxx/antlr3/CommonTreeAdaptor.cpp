@@ -45,7 +45,7 @@ CommonTreeAdaptor::CommonTreeAdaptor() {}
 CommonTreeAdaptor::~CommonTreeAdaptor() {}
 
 ItemPtr CommonTreeAdaptor::create(CommonTokenPtr payload) {
-    return std::make_shared<CommonTree>(std::move(payload));
+    return makeShared<CommonTree>(std::move(payload));
 }
 ItemPtr CommonTreeAdaptor::dupNode(ItemPtr treeNode) {
     return std::static_pointer_cast<CommonTree>(treeNode)->dupNode();
@@ -56,7 +56,7 @@ ItemPtr CommonTreeAdaptor::errorNode(
     CommonTokenPtr stop,
     ExceptionPtr e
 ) {
-    return std::make_shared<CommonErrorNode>(input, start, stop, e);
+    return makeShared<CommonErrorNode>(input, start, stop, e);
 }
 
 bool CommonTreeAdaptor::isNil(ItemPtr t) {
@@ -66,18 +66,18 @@ bool CommonTreeAdaptor::isNil(ItemPtr t) {
 // R e w r i t e  R u l e s
 
 ItemPtr CommonTreeAdaptor::create(std::uint32_t tokenType, CommonTokenPtr fromToken) {
-    auto tok = fromToken ? std::make_shared<CommonToken>(*fromToken) : std::make_shared<CommonToken>();
+    auto tok = fromToken ? makeShared<CommonToken>(*fromToken) : makeShared<CommonToken>();
     tok->setType(tokenType);
     return create(tok);
 }
 ItemPtr CommonTreeAdaptor::create(std::uint32_t tokenType, CommonTokenPtr fromToken, String text) {
-    auto tok = fromToken ? std::make_shared<CommonToken>(*fromToken) : std::make_shared<CommonToken>();
+    auto tok = fromToken ? makeShared<CommonToken>(*fromToken) : makeShared<CommonToken>();
     tok->setType(tokenType);
     tok->setText(std::move(text));
     return create(tok);
 }
 ItemPtr CommonTreeAdaptor::create(std::uint32_t tokenType, String text) {
-    auto tok = std::make_shared<CommonToken>(tokenType, std::move(text));
+    auto tok = makeShared<CommonToken>(tokenType, std::move(text));
     return create(tok);
 }
 
@@ -42,17 +42,17 @@ CommonTreeNodeStream::CommonTreeNodeStream(ItemPtr tree)
 
 CommonTreeNodeStream::CommonTreeNodeStream(TreeAdaptorPtr adaptor, ItemPtr tree)
     : TreeNodeStream()
-    , downNode_(std::make_shared<CommonTree>(
-        std::make_shared<CommonToken>(TokenDown, ANTLR3_T("DOWN"))
+    , downNode_(makeShared<CommonTree>(
+        makeShared<CommonToken>(TokenDown, ANTLR3_T("DOWN"))
       ))
-    , upNode_(std::make_shared<CommonTree>(
-        std::make_shared<CommonToken>(TokenUp, ANTLR3_T("UP"))
+    , upNode_(makeShared<CommonTree>(
+        makeShared<CommonToken>(TokenUp, ANTLR3_T("UP"))
       ))
-    , eofNode_(std::make_shared<CommonTree>(
-        std::make_shared<CommonToken>(TokenEof, ANTLR3_T("EOF"))
+    , eofNode_(makeShared<CommonTree>(
+        makeShared<CommonToken>(TokenEof, ANTLR3_T("EOF"))
       ))
-    , invalidNode_(std::make_shared<CommonTree>(
-        std::make_shared<CommonToken>(TokenInvalid, ANTLR3_T("INVALID"))
+    , invalidNode_(makeShared<CommonTree>(
+        makeShared<CommonToken>(TokenInvalid, ANTLR3_T("INVALID"))
       ))
     , nodes_()
     , uniqueNavigationNodes_(false)
@@ -66,10 +66,10 @@ CommonTreeNodeStream::CommonTreeNodeStream(TreeAdaptorPtr adaptor, ItemPtr tree)
 
 CommonTreeNodeStream::CommonTreeNodeStream(CommonTreeNodeStream const * inStream)
     : TreeNodeStream()
-    , downNode_(std::make_shared<CommonTree>(inStream->downNode_->token()))
-    , upNode_(std::make_shared<CommonTree>(inStream->upNode_->token()))
-    , eofNode_(std::make_shared<CommonTree>(inStream->eofNode_->token()))
-    , invalidNode_(std::make_shared<CommonTree>(inStream->invalidNode_->token()))
+    , downNode_(makeShared<CommonTree>(inStream->downNode_->token()))
+    , upNode_(makeShared<CommonTree>(inStream->upNode_->token()))
+    , eofNode_(makeShared<CommonTree>(inStream->eofNode_->token()))
+    , invalidNode_(makeShared<CommonTree>(inStream->invalidNode_->token()))
     , nodes_()
     , uniqueNavigationNodes_(false)
     , root_(inStream->root_)
@@ -264,7 +264,7 @@ std::uint32_t CommonTreeNodeStream::LA(std::int32_t i)
 ///
 MarkerPtr CommonTreeNodeStream::mark()
 {
-    return std::make_shared<TreeNodeStreamMarker>(index(), shared_from_this());
+    return makeShared<TreeNodeStreamMarker>(index(), shared_from_this());
 }
 
 /// consume() ahead until we hit index.  Can't just jump ahead--must
@@ -410,14 +410,14 @@ void CommonTreeNodeStream::toStringWork(ItemPtr p, ItemPtr stop, String& buf)
 
 ItemPtr CommonTreeNodeStream::newDownNode()
 {
-    CommonTokenPtr token = std::make_shared<CommonToken>(TokenDown, ANTLR3_T("DOWN"));
-    return std::make_shared<CommonTree>(token);
+    CommonTokenPtr token = makeShared<CommonToken>(TokenDown, ANTLR3_T("DOWN"));
+    return makeShared<CommonTree>(token);
 }
 
 ItemPtr CommonTreeNodeStream::newUpNode()
 {
-    CommonTokenPtr token = std::make_shared<CommonToken>(TokenUp, ANTLR3_T("UP"));
-    return std::make_shared<CommonTree>(token);
+    CommonTokenPtr token = makeShared<CommonToken>(TokenUp, ANTLR3_T("UP"));
+    return makeShared<CommonTree>(token);
 }
 
 /// Replace from start to stop child index of parent with t, which might
@@ -51,7 +51,7 @@ namespace antlr3 {
 class TreeNodeStream : public IntStream
 {
 public:
-    virtual ItemPtr LI(std::int32_t i) override { return LT(i); }
+    virtual Item LI(std::int32_t i) override { return LT(i); }
 
     /// Get tree node at current input pointer + i ahead where i=1 is next node.
     /// i<0 indicates nodes in the past. So LT(-1) is previous node, but
@@ -126,7 +126,7 @@ public:
 
 };
 
-class CommonTreeNodeStream : public TreeNodeStream, public std::enable_shared_from_this<CommonTreeNodeStream>
+class CommonTreeNodeStream : public TreeNodeStream, public EnableSharedFromThis<CommonTreeNodeStream>
 {
     class TreeNodeStreamMarker : public Marker
     {
@@ -190,14 +190,14 @@ class CommonTreeNodeStream : public TreeNodeStream, public std::enable_shared_fr
     /// Pointer to tree adaptor interface that manipulates/builds
     /// the tree.
     ///
-    std::shared_ptr<TreeAdaptor> adaptor_;
+    SharedPtr<TreeAdaptor> adaptor_;
 
     /// As we walk down the nodes, we must track parent nodes so we know
     /// where to go after walking the last child of a node. When visiting
     /// a child, push current node and current index (current index
     /// is first stored in the tree node structure to avoid two stacks.
     ///
-    std::shared_ptr<std::stack<Index>> nodeStack_;
+    SharedPtr<std::stack<Index>> nodeStack_;
 
     /// The current index into the nodes vector of the current tree
     /// we are parsing and possibly rewriting.
@@ -227,6 +227,8 @@ public:
     virtual void consume() override;
     virtual std::uint32_t LA(std::int32_t i) override;
     virtual MarkerPtr mark() override;
+    virtual Checkpoint checkpoint() override { return Checkpoint(index()); }
+    virtual void restore(Checkpoint const & cp) override { seek(cp.index()); }
     virtual Index index() override;
     virtual void seek(Index index) override;
 
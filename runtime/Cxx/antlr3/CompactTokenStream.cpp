@@ -0,0 +1,507 @@
+/** \file
+ * Implementation of the structure-of-arrays token stream.
+ */
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/CompactTokenStream.hpp>
+#include <algorithm>
+
+namespace antlr3 {
+
+Location TokenHandle::startLocation() const
+{
+    LocationSourcePtr const & input = stream_->inputStream(index_);
+    return input ? input->location(startIndex()) : Location();
+}
+
+CommonTokenPtr TokenHandle::token() const
+{
+    CommonTokenPtr tok = makeShared<CommonToken>();
+    copyTo(*tok);
+    return tok;
+}
+
+void TokenHandle::copyTo(CommonToken & tok) const
+{
+    tok = CommonToken(type());
+    tok.setChannel(channel());
+    tok.setTokenIndex(index_);
+    tok.setInputStream(stream_->inputStream(index_));
+    tok.setStartIndex(startIndex());
+    tok.setStopIndex(stopIndex());
+
+    // Text is copied only if it was overridden
+    //
+    if(stream_->hasText(index_))
+    {
+        tok.setText(text());
+    }
+}
+
+CompactTokenStream::CompactTokenStream(TokenSourcePtr source)
+    : TokenStream()
+    , tokenSource_(std::move(source))
+    , types_()
+    , channels_()
+    , starts_()
+    , stops_()
+    , texts_()
+    , sources_()
+    , channelOverrides_()
+    , discardTypes_()
+    , tokenCache_()
+    , channel_(TokenDefaultChannel)
+    , discardOffChannel_(false)
+    , p_(NullIndex)
+{
+}
+
+CompactTokenStream::~CompactTokenStream()
+{
+}
+
+String CompactTokenStream::sourceName()
+{
+    // Streams filled by assign() may have no token source
+    //
+    if(!tokenSource_)
+    {
+        return sources_.empty() ? String() : sources_.front().second->sourceName();
+    }
+    return tokenSource_->source()->sourceName();
+}
+
+void CompactTokenStream::consume()
+{
+    if(p_ < types_.size())
+    {
+        p_++;
+        p_ = skipOffTokenChannels(p_);
+    }
+}
+
+std::uint32_t CompactTokenStream::LA(std::int32_t i)
+{
+    Index n = lookIndex(i);
+    return n != NullIndex ? types_[n] : TokenInvalid;
+}
+
+MarkerPtr CompactTokenStream::mark()
+{
+    return makeShared<CompactTokenStreamMarker>(index(), shared_from_this());
+}
+
+Index CompactTokenStream::index()
+{
+    fillBufferIfNeeded();
+    return p_;
+}
+
+void CompactTokenStream::seek(Index index)
+{
+    p_ = index;
+}
+
+CommonTokenPtr CompactTokenStream::LT(std::int32_t k)
+{
+    Index i = lookIndex(k);
+    return i != NullIndex ? cachedToken(i) : CommonTokenPtr();
+}
+
+CommonTokenPtr CompactTokenStream::get(Index i)
+{
+    fillBufferIfNeeded();
+    assert(i < types_.size());
+    return cachedToken(i);
+}
+
+TokenSourcePtr CompactTokenStream::tokenSource()
+{
+    return tokenSource_;
+}
+
+String CompactTokenStream::toString()
+{
+    fillBufferIfNeeded();
+    return toString(0, (std::uint32_t)types_.size());
+}
+
+String CompactTokenStream::toString(std::uint32_t start, std::uint32_t stop)
+{
+    fillBufferIfNeeded();
+
+    const std::uint32_t maxIndex = (std::uint32_t)types_.size() - 1;
+    start = std::min(start, maxIndex);
+    stop = std::min(stop, maxIndex);
+
+    if(start >= stop)
+    {
+        return String();
+    }
+
+    // Contiguous tokens are sliced out of the input in one go,
+    // even if the input cannot provide a view
+    //
+    if(isContiguous(start, stop - 1))
+    {
+        return inputStream(start)->substr(starts_[start], stops_[stop - 1]);
+    }
+
+    String string;
+    for(std::uint32_t i = start; i < stop; i++)
+    {
+        string += text(i);
+    }
+    return string;
+}
+
+String CompactTokenStream::toString(CommonTokenPtr start, CommonTokenPtr stop)
+{
+    if(start != NULL && stop != NULL)
+    {
+        return toString((std::uint32_t)start->tokenIndex(), (std::uint32_t)stop->tokenIndex());
+    }
+    else
+    {
+        return ANTLR3_T("");
+    }
+}
+
+StringView CompactTokenStream::spanText(std::uint32_t start, std::uint32_t stop)
+{
+    fillBufferIfNeeded();
+
+    const std::uint32_t maxIndex = (std::uint32_t)types_.size() - 1;
+    start = std::min(start, maxIndex);
+    stop = std::min(stop, maxIndex);
+
+    if(start >= stop)
+    {
+        return StringView(ANTLR3_T(""), 0);
+    }
+
+    if(!isContiguous(start, stop - 1))
+    {
+        return StringView();
+    }
+
+    return inputStream(start)->textView(starts_[start], stops_[stop - 1]);
+}
+
+TokenHandle CompactTokenStream::handle(std::int32_t k)
+{
+    Index i = lookIndex(k);
+    return i != NullIndex ? TokenHandle(this, i) : TokenHandle();
+}
+
+TokenHandle CompactTokenStream::handleAt(Index i)
+{
+    fillBufferIfNeeded();
+    assert(i < types_.size());
+    return TokenHandle(this, i);
+}
+
+Index CompactTokenStream::size()
+{
+    fillBufferIfNeeded();
+    return types_.size();
+}
+
+LocationSourcePtr const & CompactTokenStream::inputStream(Index i) const
+{
+    // Find the last run that starts at or before i
+    //
+    auto it = std::upper_bound(sources_.begin(), sources_.end(), i,
+        [](Index x, std::pair<Index, LocationSourcePtr> const & run) { return x < run.first; });
+    assert(it != sources_.begin());
+    return (it - 1)->second;
+}
+
+String CompactTokenStream::text(Index i) const
+{
+    auto textI = texts_.find(i);
+    if(textI != texts_.end())
+    {
+        return textI->second;
+    }
+
+    if(types_[i] == TokenEof)
+    {
+        return ANTLR3_T("<EOF>");
+    }
+
+    LocationSourcePtr const & input = inputStream(i);
+    return input ? input->substr(starts_[i], stops_[i]) : String();
+}
+
+StringView CompactTokenStream::textView(Index i) const
+{
+    auto textI = texts_.find(i);
+    if(textI != texts_.end())
+    {
+        return StringView(textI->second);
+    }
+
+    if(types_[i] == TokenEof)
+    {
+        return StringView(ANTLR3_T("<EOF>"), 5);
+    }
+
+    LocationSourcePtr const & input = inputStream(i);
+    return input ? input->textView(starts_[i], stops_[i]) : StringView(ANTLR3_T(""), 0);
+}
+
+void CompactTokenStream::setText(Index i, String text)
+{
+    texts_[i] = std::move(text);
+
+    // Cached token would still have the old text
+    //
+    CommonTokenPtr & cached = tokenCache_[i % TokenCacheSize];
+    if(cached && cached->tokenIndex() == i)
+    {
+        cached.reset();
+    }
+}
+
+void CompactTokenStream::setTokenTypeChannel(std::uint32_t ttype, std::uint32_t channel)
+{
+    // Zero means no override, so the channel is stored plus one
+    //
+    if(ttype >= channelOverrides_.size())
+    {
+        channelOverrides_.resize(ttype + 1);
+    }
+    channelOverrides_[ttype] = channel + 1;
+}
+
+void CompactTokenStream::discardTokenType(std::uint32_t ttype)
+{
+    assert(ttype != TokenEof);
+
+    if(ttype >= discardTypes_.size())
+    {
+        discardTypes_.resize(ttype + 1);
+    }
+    discardTypes_[ttype] = true;
+}
+
+void CompactTokenStream::discardOffChannelToks(bool discard)
+{
+    discardOffChannel_ = discard;
+}
+
+void CompactTokenStream::assign(Index count, std::uint32_t const * types, std::uint32_t const * channels,
+                                std::uint32_t const * starts, std::uint32_t const * stops, LocationSourcePtr input)
+{
+    assert(p_ == NullIndex && types_.empty());
+    assert(count > 0 && types[count - 1] == TokenEof);
+
+    types_.assign(types, types + count);
+    channels_.assign(channels, channels + count);
+    starts_.assign(starts, starts + count);
+    stops_.assign(stops, stops + count);
+    sources_.emplace_back(0, std::move(input));
+
+    p_ = skipOffTokenChannels(0);
+}
+
+void CompactTokenStream::reset()
+{
+    discardTypes_.clear();
+    channelOverrides_.clear();
+    for(CommonTokenPtr & cached : tokenCache_)
+    {
+        cached.reset();
+    }
+
+    types_.clear();
+    channels_.clear();
+    starts_.clear();
+    stops_.clear();
+    texts_.clear();
+    sources_.clear();
+
+    discardOffChannel_  = false;
+    channel_            = TokenDefaultChannel;
+    p_                  = NullIndex;
+}
+
+void CompactTokenStream::fillBufferIfNeeded()
+{
+    if (p_ != NullIndex) {
+        return;
+    }
+
+    while(true)
+    {
+        CommonTokenPtr tok = tokenSource_->nextToken();
+        append(*tok);
+        if (tok->type() == TokenEof) {
+            break;
+        }
+    }
+
+    // Set the consume pointer to the first token that is on our channel
+    p_ = skipOffTokenChannels(0);
+}
+
+void CompactTokenStream::append(CommonToken const & token)
+{
+    std::uint32_t type = token.type();
+    std::uint32_t channel = token.channel();
+
+    if(type < channelOverrides_.size() && channelOverrides_[type] != 0)
+    {
+        channel = channelOverrides_[type] - 1;
+    }
+
+    // EOF is always kept so that lookahead has something to stop at
+    //
+    bool discarded = type < discardTypes_.size() && discardTypes_[type];
+    if(type != TokenEof && (discarded || (discardOffChannel_ && channel != channel_)))
+    {
+        return;
+    }
+
+    Index index = types_.size();
+    LocationSourcePtr input = token.inputStream();
+    if(sources_.empty() || sources_.back().second != input)
+    {
+        sources_.emplace_back(index, std::move(input));
+    }
+
+    // Offsets are stored in 32 bits, same as character streams limit their size
+    //
+    assert(token.startIndex() <= 0xFFFFFFFF && token.stopIndex() <= 0xFFFFFFFF);
+    types_.push_back(type);
+    channels_.push_back(channel);
+    starts_.push_back((std::uint32_t)token.startIndex());
+    stops_.push_back((std::uint32_t)token.stopIndex());
+
+    if(token.hasText())
+    {
+        texts_[index] = token.text();
+    }
+}
+
+CommonTokenPtr CompactTokenStream::cachedToken(Index i)
+{
+    CommonTokenPtr & cached = tokenCache_[i % TokenCacheSize];
+    if(cached && cached->tokenIndex() == i)
+    {
+        return cached;
+    }
+
+    // Evicted token is reused in place if nobody else refers to it
+    //
+    if(!cached || cached.use_count() > 1)
+    {
+        cached = makeShared<CommonToken>();
+    }
+    TokenHandle(this, i).copyTo(*cached);
+    return cached;
+}
+
+Index CompactTokenStream::skipOffTokenChannels(Index i) const
+{
+    Index n = channels_.size();
+    while(i < n && channels_[i] != channel_)
+    {
+        i++;
+    }
+    return i;
+}
+
+Index CompactTokenStream::skipOffTokenChannelsReverse(Index x) const
+{
+    while(x != NullIndex && channels_[x] != channel_)
+    {
+        x--;
+    }
+    return x;
+}
+
+Index CompactTokenStream::lookIndex(std::int32_t k)
+{
+    fillBufferIfNeeded();
+
+    if(k == 0)
+    {
+        return NullIndex;
+    }
+
+    Index i = p_;
+    if(k < 0)
+    {
+        // Need to find -k good tokens, going backwards
+        //
+        for(std::int32_t n = 0; n < -k && i != NullIndex; n++)
+        {
+            i = i == 0 ? NullIndex : skipOffTokenChannelsReverse(i - 1);
+        }
+        return i;
+    }
+
+    // Need to find k good tokens, skipping ones that are off channel.
+    // Everything past the end reads as EOF, which is the last token.
+    //
+    Index last = types_.size() - 1;
+    for(std::int32_t n = 1; n < k && i < last; n++)
+    {
+        i = skipOffTokenChannels(i + 1);
+    }
+    return std::min(i, last);
+}
+
+bool CompactTokenStream::isContiguous(Index start, Index stop) const
+{
+    LocationSourcePtr const & input = inputStream(start);
+    if(input == nullptr)
+    {
+        return false;
+    }
+
+    for(Index i = start; i <= stop; i++)
+    {
+        if(texts_.count(i) > 0)
+        {
+            return false;
+        }
+        if(i > start && (starts_[i] != stops_[i - 1] || inputStream(i) != input))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace antlr3
@@ -0,0 +1,235 @@
+/** \file
+ * Defines a token stream that stores tokens as parallel arrays instead of
+ * individually allocated CommonToken objects.
+ */
+#ifndef _ANTLR3_COMPACT_TOKENSTREAM_HPP
+#define _ANTLR3_COMPACT_TOKENSTREAM_HPP
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/TokenStream.hpp>
+
+namespace antlr3 {
+
+class CompactTokenStream;
+
+/// Cheap reference to a token stored in CompactTokenStream.
+/// Handle is valid as long as the stream is alive and is not reset.
+class TokenHandle
+{
+public:
+    TokenHandle()
+        : stream_()
+        , index_(NullIndex)
+    {}
+
+    TokenHandle(CompactTokenStream const * stream, Index index)
+        : stream_(stream)
+        , index_(index)
+    {}
+
+    /// Returns false for handles that do not refer to any token.
+    explicit operator bool() const { return stream_ != nullptr; }
+
+    Index tokenIndex() const { return index_; }
+    std::uint32_t type() const;
+    std::uint32_t channel() const;
+    Index startIndex() const;
+    Index stopIndex() const;
+    Location startLocation() const;
+    String text() const;
+    StringView textView() const;
+
+    /// Creates a CommonToken with the same contents.
+    /// Changes made to the created token are not reflected in the stream.
+    CommonTokenPtr token() const;
+
+    /// Overwrites all fields of \a tok with the contents of this token.
+    void copyTo(CommonToken & tok) const;
+private:
+    CompactTokenStream const * stream_;
+    Index index_;
+};
+
+/** Token stream that keeps types, channels and character offsets of the tokens
+ *  in parallel arrays, and overridden token text in a side table.
+ *  This takes 16 bytes per token instead of a CommonToken allocation, and makes
+ *  lookahead scans by LA() touch only contiguous arrays.
+ *
+ *  Tokens are read from the source the same way CommonTokenStream does. LT() and get()
+ *  create CommonToken objects on demand and keep the last few of them, so repeated
+ *  lookahead at the same tokens does not allocate. Code that only needs token fields
+ *  should use handle() and handleAt() instead.
+ */
+class CompactTokenStream : public TokenStream, public EnableSharedFromThis<CompactTokenStream>
+{
+    class CompactTokenStreamMarker : public Marker
+    {
+        Index p_;
+        CompactTokenStreamPtr stream_;
+    public:
+        CompactTokenStreamMarker(Index p, CompactTokenStreamPtr stream)
+            : Marker()
+            , p_(p)
+            , stream_(stream)
+        {}
+
+        virtual void rewind() {
+            stream_->p_ = p_;
+        }
+    };
+
+    /// Pointer to the token source for this stream
+    TokenSourcePtr tokenSource_;
+
+    /// Token fields, indexed by the token index.
+    std::vector<std::uint32_t> types_;
+    std::vector<std::uint32_t> channels_;
+    std::vector<std::uint32_t> starts_;
+    std::vector<std::uint32_t> stops_;
+
+    /// Text of the tokens that had it overridden.
+    std::unordered_map<Index, String> texts_;
+
+    /// Input streams, each paired with the index of the first token taken from it.
+    std::vector<std::pair<Index, LocationSourcePtr>> sources_;
+
+    /// Channel overrides, indexed by token type. A non-zero entry is the
+    /// override channel number plus one.
+    std::vector<std::uint32_t> channelOverrides_;
+
+    /// Discard table, indexed by token type.
+    std::vector<bool> discardTypes_;
+
+    /// Number of tokens kept by LT() and get().
+    static const std::size_t TokenCacheSize = 8;
+
+    /// Tokens most recently created by LT() and get(), slot is chosen by the token index.
+    CommonTokenPtr tokenCache_[TokenCacheSize];
+
+    /// The channel number that this token stream is tuned to.
+    std::uint32_t channel_;
+
+    /// If true, tokens that are not on channel_ are not stored.
+    bool discardOffChannel_;
+
+    /// The index of the current token, NullIndex until the buffer is filled.
+    Index p_;
+
+    void fillBufferIfNeeded();
+    void append(CommonToken const & token);
+    Index skipOffTokenChannels(Index i) const;
+    Index skipOffTokenChannelsReverse(Index i) const;
+
+    /// Returns index of the k-th on-channel token relative to the current one,
+    /// or NullIndex if there is no such token.
+    Index lookIndex(std::int32_t k);
+
+    /// Returns true if tokens from start to stop follow each other in the same
+    /// input stream and have no overridden text.
+    bool isContiguous(Index start, Index stop) const;
+
+    /// Returns the token with index \a i, creating it if it is not in the cache.
+    CommonTokenPtr cachedToken(Index i);
+public:
+    CompactTokenStream(TokenSourcePtr source);
+    ~CompactTokenStream();
+
+    /// IntStream
+
+    virtual String sourceName() override;
+    virtual void consume() override;
+    virtual std::uint32_t LA(std::int32_t i) override;
+    virtual Item LI(std::int32_t i) override { return LT(i); }
+    virtual MarkerPtr mark() override;
+    virtual Checkpoint checkpoint() override { return Checkpoint(index()); }
+    virtual void restore(Checkpoint const & cp) override { seek(cp.index()); }
+    virtual Index index() override;
+    virtual void seek(Index index) override;
+
+    /// TokenStream
+
+    virtual CommonTokenPtr LT(std::int32_t k) override;
+    virtual CommonTokenPtr get(Index i) override;
+    virtual TokenSourcePtr tokenSource() override;
+    virtual String toString() override;
+    virtual String toString(std::uint32_t start, std::uint32_t stop) override;
+    virtual String toString(CommonTokenPtr start, CommonTokenPtr stop) override;
+    virtual StringView spanText(std::uint32_t start, std::uint32_t stop) override;
+
+    /// Returns handle of the token that LT(k) would return.
+    TokenHandle handle(std::int32_t k);
+
+    /// Returns handle of the token with index \a i.
+    TokenHandle handleAt(Index i);
+
+    /// Number of stored tokens, including EOF.
+    Index size();
+
+    std::uint32_t type(Index i) const { return types_[i]; }
+    std::uint32_t channel(Index i) const { return channels_[i]; }
+    Index startIndex(Index i) const { return starts_[i]; }
+    Index stopIndex(Index i) const { return stops_[i]; }
+    LocationSourcePtr const & inputStream(Index i) const;
+    String text(Index i) const;
+    StringView textView(Index i) const;
+
+    /// Returns true if text of the token with index \a i was overridden.
+    bool hasText(Index i) const { return texts_.count(i) > 0; }
+
+    /// Overrides text of the token with index \a i.
+    void setText(Index i, String text);
+
+    void setTokenTypeChannel(std::uint32_t ttype, std::uint32_t channel);
+    void discardTokenType(std::uint32_t ttype);
+    void discardOffChannelToks(bool discard);
+
+    /** Fills the stream with \a count tokens stored elsewhere, such as in a token cache,
+     *  instead of reading them from the token source. Field arrays are copied in bulk,
+     *  and all tokens refer to \a input. Channel overrides and discards are not applied.
+     *  Must be called before the stream is used.
+     */
+    void assign(Index count, std::uint32_t const * types, std::uint32_t const * channels,
+                std::uint32_t const * starts, std::uint32_t const * stops, LocationSourcePtr input);
+
+    /// Clears the stream so it can be reused, keeping allocated memory.
+    void reset();
+};
+
+inline std::uint32_t TokenHandle::type() const { return stream_->type(index_); }
+inline std::uint32_t TokenHandle::channel() const { return stream_->channel(index_); }
+inline Index TokenHandle::startIndex() const { return stream_->startIndex(index_); }
+inline Index TokenHandle::stopIndex() const { return stream_->stopIndex(index_); }
+inline String TokenHandle::text() const { return stream_->text(index_); }
+inline StringView TokenHandle::textView() const { return stream_->textView(index_); }
+
+} // namespace antlr3
+
+#endif
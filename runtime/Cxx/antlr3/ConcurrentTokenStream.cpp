@@ -0,0 +1,165 @@
+/** \file
+ * Implementation of the concurrent token source and stream.
+ */
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/ConcurrentTokenStream.hpp>
+
+namespace antlr3 {
+
+namespace {
+
+std::size_t roundUpToPowerOfTwo(std::size_t n)
+{
+    std::size_t retVal = 1;
+    while (retVal < n) {
+        retVal <<= 1;
+    }
+    return retVal;
+}
+
+} // namespace
+
+ConcurrentTokenSource::ConcurrentTokenSource(TokenSourcePtr source, std::size_t capacity)
+    : TokenSource()
+    , source_(std::move(source))
+    , locationSource_(source_->source())
+    , ring_(roundUpToPowerOfTwo(std::max<std::size_t>(capacity, 2)))
+    , mask_(ring_.size() - 1)
+    , head_(0)
+    , tail_(0)
+    , stop_(false)
+    , cachedHead_(0)
+    , consumerTail_(0)
+    , eof_()
+    , error_()
+    , failed_(false)
+    , producer_()
+{
+#if !ANTLR3_SINGLE_THREADED
+    producer_ = std::thread(&ConcurrentTokenSource::produce, this);
+#endif
+}
+
+ConcurrentTokenSource::~ConcurrentTokenSource()
+{
+    if (producer_.joinable()) {
+        stop_.store(true, std::memory_order_relaxed);
+        producer_.join();
+    }
+}
+
+CommonTokenPtr ConcurrentTokenSource::nextToken()
+{
+    if (eof_) {
+        return eof_;
+    }
+    if (failed_) {
+        std::rethrow_exception(error_);
+    }
+
+#if ANTLR3_SINGLE_THREADED
+    CommonTokenPtr token = source_->nextToken();
+#else
+    while (consumerTail_ == cachedHead_) {
+        cachedHead_ = head_.load(std::memory_order_acquire);
+        if (consumerTail_ == cachedHead_) {
+            std::this_thread::yield();
+        }
+    }
+
+    CommonTokenPtr token = std::move(ring_[consumerTail_ & mask_]);
+    tail_.store(++consumerTail_, std::memory_order_release);
+    if (!token) {
+        failed_ = true;
+        std::rethrow_exception(error_);
+    }
+#endif
+
+    if (token->type() == TokenEof) {
+        eof_ = token;
+    }
+    return token;
+}
+
+LocationSourcePtr ConcurrentTokenSource::source()
+{
+    return locationSource_;
+}
+
+void ConcurrentTokenSource::produce()
+{
+    std::size_t head = 0;
+    std::size_t cachedTail = 0;
+    for (;;) {
+        // An exception is passed on as a null token, after which there is nothing more to produce
+        //
+        CommonTokenPtr token;
+        try {
+            token = source_->nextToken();
+        }
+        catch (...) {
+            error_ = std::current_exception();
+        }
+        bool last = !token || token->type() == TokenEof;
+
+        // Wait for the consumer to free a slot
+        //
+        while (head - cachedTail == ring_.size()) {
+            if (stop_.load(std::memory_order_relaxed)) {
+                return;
+            }
+            cachedTail = tail_.load(std::memory_order_acquire);
+            if (head - cachedTail == ring_.size()) {
+                std::this_thread::yield();
+            }
+        }
+
+        ring_[head & mask_] = std::move(token);
+        head_.store(++head, std::memory_order_release);
+
+        if (last || stop_.load(std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+ConcurrentTokenStream::ConcurrentTokenStream(TokenSourcePtr source, std::size_t capacity)
+    : CommonTokenStream(makeShared<ConcurrentTokenSource>(std::move(source), capacity))
+{
+    setLazy(true);
+}
+
+ConcurrentTokenStream::~ConcurrentTokenStream()
+{
+}
+
+} // namespace antlr3
@@ -0,0 +1,119 @@
+/** \file
+ * Defines a token stream that lexes on a separate thread while the
+ * parser consumes tokens.
+ */
+#ifndef _ANTLR3_CONCURRENTTOKENSTREAM_HPP
+#define _ANTLR3_CONCURRENTTOKENSTREAM_HPP
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/TokenStream.hpp>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace antlr3 {
+
+/** Token source that runs another token source on a producer thread.
+ *
+ *  Tokens are passed to the consumer through a fixed-size single-producer,
+ *  single-consumer ring buffer without locks. The producer waits while the ring
+ *  is full and stops after the EOF token, the consumer waits while it is empty.
+ *  Positions of the other side are cached, so shared counters are only read
+ *  again when the cached value runs out.
+ *
+ *  The wrapped source is used only by the producer thread once this source
+ *  is constructed. If it throws, the producer stops and nextToken() rethrows
+ *  the exception on the consumer thread once the tokens before it are taken,
+ *  and on every call after that. When the runtime is built with ANTLR3_SINGLE_THREADED,
+ *  no thread is started and nextToken() calls the wrapped source directly.
+ */
+class ConcurrentTokenSource : public TokenSource
+{
+public:
+    /** \a capacity is rounded up to a power of two.
+     */
+    ConcurrentTokenSource(TokenSourcePtr source, std::size_t capacity = 1024);
+    ~ConcurrentTokenSource();
+
+    virtual CommonTokenPtr nextToken() override;
+    virtual LocationSourcePtr source() override;
+private:
+    void produce();
+
+    TokenSourcePtr source_;
+    LocationSourcePtr locationSource_;
+
+    std::vector<CommonTokenPtr> ring_;
+    std::size_t mask_;
+
+    /// Number of tokens published by the producer.
+    std::atomic<std::size_t> head_;
+
+    /// Number of tokens taken by the consumer.
+    std::atomic<std::size_t> tail_;
+
+    /// Set when the consumer is destroyed, so that the producer stops waiting.
+    std::atomic<bool> stop_;
+
+    /// Consumer's copies of head_ and tail_.
+    std::size_t cachedHead_;
+    std::size_t consumerTail_;
+
+    /// EOF token, returned again once the input is exhausted.
+    CommonTokenPtr eof_;
+
+    /// Exception thrown by the wrapped source. The producer sets it before
+    /// publishing the null token that stands for it.
+    std::exception_ptr error_;
+
+    /// Set by the consumer once it has taken that null token.
+    bool failed_;
+
+    std::thread producer_;
+};
+
+/** Token stream that overlaps lexing with parsing.
+ *
+ *  The token source runs on a producer thread through ConcurrentTokenSource,
+ *  and the stream reads tokens lazily as lookahead requires. Otherwise it is
+ *  a CommonTokenStream, with LT(k), mark() and rewind() working as usual.
+ */
+class ConcurrentTokenStream : public CommonTokenStream
+{
+public:
+    ConcurrentTokenStream(TokenSourcePtr source, std::size_t capacity = 1024);
+    ~ConcurrentTokenStream();
+};
+
+} // namespace antlr3
+
+#endif
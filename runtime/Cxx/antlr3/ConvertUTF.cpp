@@ -40,6 +40,20 @@ See the header file ANTLR3_T("ConvertUTF.h") for complete documentation.
 
 
 #include <antlr3/ConvertUTF.hpp>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ANTLR3_UTF_AVX2 1
+#define ANTLR3_UTF_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ANTLR3_UTF_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace utf {
 
@@ -84,4 +98,106 @@ const UTF32 offsetsFromUTF8[6] = {
  */
 const UTF8 firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
 
+/* --------------------------------------------------------------------- */
+
+#if ANTLR3_UTF_SSE2
+static inline unsigned CountTrailingZeros(unsigned mask)
+{
+#if defined(_MSC_VER)
+    unsigned long n;
+    _BitScanForward(&n, mask);
+    return n;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+UTF8 const * FindNonAscii(UTF8 const * begin, UTF8 const * end)
+{
+    UTF8 const * p = begin;
+#if ANTLR3_UTF_AVX2
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p));
+        unsigned mask = unsigned(_mm256_movemask_epi8(v));
+        if (mask != 0) {
+            return p + CountTrailingZeros(mask);
+        }
+    }
+#endif
+#if ANTLR3_UTF_SSE2
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+        unsigned mask = unsigned(_mm_movemask_epi8(v));
+        if (mask != 0) {
+            return p + CountTrailingZeros(mask);
+        }
+    }
+#endif
+    for (; end - p >= 8; p += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        if (word & 0x8080808080808080ull) {
+            break;
+        }
+    }
+    while (p < end && *p < 0x80) {
+        ++p;
+    }
+    return p;
+}
+
+UTF16 const * FindNonAscii(UTF16 const * begin, UTF16 const * end)
+{
+    UTF16 const * p = begin;
+#if ANTLR3_UTF_AVX2
+    {
+        __m256i const highBits = _mm256_set1_epi16(short(0xFF80));
+        __m256i const zero = _mm256_setzero_si256();
+        for (; end - p >= 16; p += 16) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p));
+            __m256i ascii = _mm256_cmpeq_epi16(_mm256_and_si256(v, highBits), zero);
+            unsigned mask = ~unsigned(_mm256_movemask_epi8(ascii));
+            if (mask != 0) {
+                return p + CountTrailingZeros(mask) / 2;
+            }
+        }
+    }
+#endif
+#if ANTLR3_UTF_SSE2
+    {
+        __m128i const highBits = _mm_set1_epi16(short(0xFF80));
+        __m128i const zero = _mm_setzero_si128();
+        for (; end - p >= 8; p += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+            __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, highBits), zero);
+            unsigned mask = ~unsigned(_mm_movemask_epi8(ascii)) & 0xFFFF;
+            if (mask != 0) {
+                return p + CountTrailingZeros(mask) / 2;
+            }
+        }
+    }
+#endif
+    for (; end - p >= 4; p += 4) {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        if (word & 0xFF80FF80FF80FF80ull) {
+            break;
+        }
+    }
+    while (p < end && *p < 0x80) {
+        ++p;
+    }
+    return p;
+}
+
+UTF32 const * FindNonAscii(UTF32 const * begin, UTF32 const * end)
+{
+    UTF32 const * p = begin;
+    while (p < end && *p < 0x80) {
+        ++p;
+    }
+    return p;
+}
+
 } // namespace utf
\ No newline at end of file
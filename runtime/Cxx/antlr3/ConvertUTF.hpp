@@ -577,11 +577,89 @@ public:
         return DummyWriteIterator(pos_++);
     }
 
+    DummyWriteIterator& operator+=(std::size_t n)
+    {
+        pos_ += n;
+        return *this;
+    }
+
+    std::size_t operator-(DummyWriteIterator other) const { return pos_ - other.pos_; }
+
     DummyRef operator*() const { return DummyRef(); }
 private:
     std::size_t pos_;
 };
 
+/* ---------------------------------------------------------------------
+    Bulk conversion of contiguous buffers.
+
+    FindNonAscii() returns pointer to the first code unit in [begin, end)
+    that is not a 7-bit ASCII character, or end if there is none. Where the
+    compiler targets SSE2 or AVX2 it checks 16 or 32 bytes per iteration,
+    otherwise it checks a machine word at a time.
+
+    ConvertBuffer() produces the same result as Convert(), but copies runs
+    of ASCII characters in bulk instead of pushing each of them through
+    Traits::Read() and Traits::Write(). Target can be either a pointer or
+    a DummyWriteIterator, so sizing passes benefit as well.
+------------------------------------------------------------------------ */
+
+UTF8 const * FindNonAscii(UTF8 const * begin, UTF8 const * end);
+UTF16 const * FindNonAscii(UTF16 const * begin, UTF16 const * end);
+UTF32 const * FindNonAscii(UTF32 const * begin, UTF32 const * end);
+
+namespace detail {
+
+template<class T> std::size_t Room(T * begin, T * end) { return end - begin; }
+template<class T> std::size_t Room(DummyWriteIterator<T> begin, DummyWriteIterator<T> end) { return end - begin; }
+
+template<class Src, class T> void CopyAscii(Src const * source, std::size_t n, T *& target)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        target[i] = T(source[i]);
+    }
+    target += n;
+}
+
+template<class Src, class T> void CopyAscii(Src const *, std::size_t n, DummyWriteIterator<T>& target)
+{
+    target += n;
+}
+
+} // namespace detail
+
+template<class SrcUTF, class DstUTF, class DstIt>
+ConversionResult ConvertBuffer(SrcUTF const *& sourceStart, SrcUTF const * sourceEnd, DstIt& targetStart, DstIt targetEnd, ConversionFlags flags) {
+    while (sourceStart < sourceEnd) {
+        if (*sourceStart < 0x80) {
+            SrcUTF const * asciiEnd = FindNonAscii(sourceStart, sourceEnd);
+            std::size_t n = asciiEnd - sourceStart;
+            std::size_t room = detail::Room(targetStart, targetEnd);
+            if (n > room) {
+                detail::CopyAscii(sourceStart, room, targetStart);
+                sourceStart += room;
+                return ConversionResult::TargetExhausted;
+            }
+            detail::CopyAscii(sourceStart, n, targetStart);
+            sourceStart = asciiEnd;
+            continue;
+        }
+
+        SrcUTF const * savedSrc = sourceStart;
+        UTF32 ch;
+        ConversionResult r = Traits<SrcUTF>::Read(sourceStart, sourceEnd, ch, flags);
+        if (r != ConversionResult::ConversionOK) {
+            return r;
+        }
+        r = Traits<DstUTF>::Write(targetStart, targetEnd, ch);
+        if (r != ConversionResult::ConversionOK) {
+            sourceStart = savedSrc;
+            return r;
+        }
+    }
+    return ConversionResult::ConversionOK;
+}
+
 } // namespace utf
 
 #endif
@@ -74,7 +74,7 @@ void CyclicDfa::noViableAlt(BaseRecognizer * rec, std::uint32_t	s) const
  */
 std::int32_t CyclicDfa::predict(void * ctx, BaseRecognizer * rec, IntStream * is) const
 {
-    MarkerPtr mark = is->mark();	    /* Store where we are right now	*/
+    Checkpoint checkpoint = is->checkpoint(); /* Store where we are right now	*/
     std::int32_t s		= 0;		    /* Always start with state 0	*/
     
 	for (;;)
@@ -87,7 +87,7 @@ std::int32_t CyclicDfa::predict(void * ctx, BaseRecognizer * rec, IntStream * is
 		 */
 		if  (specialState >= 0)
 		{
-			s = specialStateTransition(ctx, rec, is, specialState, mark);
+			s = specialStateTransition(ctx, rec, is, specialState, checkpoint);
 
 			// Error?
 			//
@@ -100,7 +100,7 @@ std::int32_t CyclicDfa::predict(void * ctx, BaseRecognizer * rec, IntStream * is
 				{
 					noViableAlt(rec, s);
 				}
-				mark->rewind();
+				is->restore(checkpoint);
 				return 0;
 			}
 			is->consume();
@@ -111,7 +111,7 @@ std::int32_t CyclicDfa::predict(void * ctx, BaseRecognizer * rec, IntStream * is
 		 */
 		if  (accept[s] >= 1)
 		{
-			mark->rewind();
+			is->restore(checkpoint);
 			return  accept[s];
 		}
 
@@ -143,7 +143,7 @@ std::int32_t CyclicDfa::predict(void * ctx, BaseRecognizer * rec, IntStream * is
 					continue;
 				}
 				noViableAlt(rec, s);
-				mark->rewind();
+				is->restore(checkpoint);
 				return	0;
 			}
 
@@ -165,14 +165,14 @@ std::int32_t CyclicDfa::predict(void * ctx, BaseRecognizer * rec, IntStream * is
 		 */
 		if(c == TokenEof && eof[s] >= 0)
 		{
-			mark->rewind();
+			is->restore(checkpoint);
 			return  accept[eof[s]];
 		}
 
 		/* No alt, so bomb
 		 */
 		noViableAlt(rec, s);
-		mark->rewind();
+		is->restore(checkpoint);
 		return 0;
 	}
 
@@ -180,7 +180,7 @@ std::int32_t CyclicDfa::predict(void * ctx, BaseRecognizer * rec, IntStream * is
 
 /** Default special state implementation
  */
-std::int32_t CyclicDfa::specialStateTransition(void * ctx, BaseRecognizer * recognizer, IntStream * is, std::int32_t s, MarkerPtr marker) const
+std::int32_t CyclicDfa::specialStateTransition(void * ctx, BaseRecognizer * recognizer, IntStream * is, std::int32_t s, Checkpoint const & checkpoint) const
 {
     if (specialStateTransitionFunc == NULL)
     {
@@ -188,7 +188,7 @@ std::int32_t CyclicDfa::specialStateTransition(void * ctx, BaseRecognizer * reco
     }
     else
     {
-        return (*specialStateTransitionFunc)(ctx, recognizer, is, s, marker);
+        return (*specialStateTransitionFunc)(ctx, recognizer, is, s, checkpoint);
     }
 }
 
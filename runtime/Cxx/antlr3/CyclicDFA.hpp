@@ -64,7 +64,7 @@ public:
         BaseRecognizer * rec,
         IntStream * is,
         std::int32_t s,
-        MarkerPtr marker
+        Checkpoint const & checkpoint
     );
 
     /// Decision number that a particular static structure
@@ -88,7 +88,7 @@ public:
 public:
     std::int32_t predict(void * ctx, BaseRecognizer * recognizer, IntStream * is) const;
 private:
-    std::int32_t specialStateTransition(void * ctx, BaseRecognizer * recognizer, IntStream * is, std::int32_t s, MarkerPtr marker) const;
+    std::int32_t specialStateTransition(void * ctx, BaseRecognizer * recognizer, IntStream * is, std::int32_t s, Checkpoint const & checkpoint) const;
     void noViableAlt(BaseRecognizer * rec, std::uint32_t s) const;
 };
 
@@ -73,12 +73,47 @@ Index const NullIndex = Index(std::ptrdiff_t(-1));
 Index const MEMO_RULE_FAILED = NullIndex - 1;
 Index const MEMO_RULE_UNKNOWN = NullIndex;
 
+/// Smart pointers used for all runtime objects.
+///
+/// Define ANTLR3_SINGLE_THREADED to 1 if runtime objects are never shared between threads.
+/// Reference counts are then updated with plain instead of atomic operations,
+/// which removes a noticeable cost from every pointer copy on the hot paths.
+/// The whole program, including generated recognizers, must be built with the same setting.
+/// This relies on the lock policy parameter of libstdc++ shared pointers.
+#if ANTLR3_SINGLE_THREADED
+
+#ifndef __GLIBCXX__
+#error ANTLR3_SINGLE_THREADED requires libstdc++
+#endif
+
+template<class T> using SharedPtr = std::__shared_ptr<T, __gnu_cxx::_S_single>;
+template<class T> using WeakPtr = std::__weak_ptr<T, __gnu_cxx::_S_single>;
+template<class T> using EnableSharedFromThis = std::__enable_shared_from_this<T, __gnu_cxx::_S_single>;
+
+template<class T, class... Args> inline SharedPtr<T> makeShared(Args&&... args)
+{
+    return std::__make_shared<T, __gnu_cxx::_S_single>(std::forward<Args>(args)...);
+}
+
+#else
+
+template<class T> using SharedPtr = std::shared_ptr<T>;
+template<class T> using WeakPtr = std::weak_ptr<T>;
+template<class T> using EnableSharedFromThis = std::enable_shared_from_this<T>;
+
+template<class T, class... Args> inline SharedPtr<T> makeShared(Args&&... args)
+{
+    return std::make_shared<T>(std::forward<Args>(args)...);
+}
+
+#endif
+
 #define ANTLR3_DECL_PTR(ClassName) \
-    typedef std::shared_ptr<class ClassName> ClassName##Ptr; \
-    typedef std::weak_ptr<class ClassName> ClassName##WeakPtr
+    typedef SharedPtr<class ClassName> ClassName##Ptr; \
+    typedef WeakPtr<class ClassName> ClassName##WeakPtr
 
-typedef std::shared_ptr<void> ItemPtr;
-typedef std::weak_ptr<void> ItemWeakPtr;
+typedef SharedPtr<void> ItemPtr;
+typedef WeakPtr<void> ItemWeakPtr;
 
 ANTLR3_DECL_PTR(Marker);
 ANTLR3_DECL_PTR(CharItem);
@@ -90,6 +125,9 @@ ANTLR3_DECL_PTR(IntStream);
 ANTLR3_DECL_PTR(CharStream);
 ANTLR3_DECL_PTR(TokenStream);
 ANTLR3_DECL_PTR(CommonTokenStream);
+ANTLR3_DECL_PTR(CompactTokenStream);
+ANTLR3_DECL_PTR(TokenRewriteStream);
+ANTLR3_DECL_PTR(ConcurrentTokenStream);
 ANTLR3_DECL_PTR(TreeNodeStream);
 ANTLR3_DECL_PTR(CommonTreeNodeStream);
 ANTLR3_DECL_PTR(RecognizerSharedState);
@@ -99,6 +137,8 @@ ANTLR3_DECL_PTR(Parser);
 ANTLR3_DECL_PTR(TreeParser);
 ANTLR3_DECL_PTR(Exception);
 ANTLR3_DECL_PTR(TokenSource);
+ANTLR3_DECL_PTR(TokenFactory);
+ANTLR3_DECL_PTR(ParallelLexer);
 ANTLR3_DECL_PTR(TreeAdaptor);
 ANTLR3_DECL_PTR(CommonTreeAdaptor);
 ANTLR3_DECL_PTR(RewriteRuleTokenStream);
@@ -110,12 +150,12 @@ ANTLR3_DECL_PTR(CyclicDfa);
     
 #undef ANTLR3_DECL_PTR
 
-template<class T, class Y> inline T pointer_cast(std::shared_ptr<Y> p)
+template<class T, class Y> inline T pointer_cast(SharedPtr<Y> p)
 {
     return std::static_pointer_cast<typename T::element_type>(std::move(p));
 }
 
-template<class T> std::shared_ptr<T> pointer_cast(std::shared_ptr<T> p)
+template<class T> SharedPtr<T> pointer_cast(SharedPtr<T> p)
 {
     return std::move(p);
 }
@@ -125,6 +165,28 @@ inline bool isBetween(std::uint32_t min, std::uint32_t val, std::uint32_t max)
     return min <= val && val <= max;
 }
 
+/// Non-owning reference to a contiguous range of elements, such as part of
+/// a buffer kept by a stream. Valid only as long as the buffer is not changed.
+template<class T>
+class Span
+{
+public:
+    typedef T value_type;
+    typedef T const * const_iterator;
+
+    Span() : begin_(), end_() {}
+    Span(T const * begin, T const * end) : begin_(begin), end_(end) {}
+
+    const_iterator begin() const { return begin_; }
+    const_iterator end() const { return end_; }
+    std::size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+    T const & operator[](std::size_t i) const { return begin_[i]; }
+private:
+    T const * begin_;
+    T const * end_;
+};
+
 } // namespace antlr3 {
 
 #endif	/* _ANTLR3DEFS_H	*/
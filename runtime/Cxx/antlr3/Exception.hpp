@@ -35,6 +35,7 @@
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <antlr3/Defs.hpp>
+#include <antlr3/Item.hpp>
 #include <antlr3/Visitor.hpp>
 #include <antlr3/Bitset.hpp>
 #include <antlr3/Location.hpp>
@@ -74,7 +75,7 @@ public:
 
     /** Indicates what the current character/token/tree was when the error occurred.
      */
-    ItemPtr item;
+    Item item;
 
     /** Track the location at which the error occurred in case this is
      *  generated from a lexer.  We need to track this since the
@@ -62,6 +62,7 @@
 
 #include <antlr3/Defs.hpp>
 #include <antlr3/String.hpp>
+#include <antlr3/Item.hpp>
 
 namespace antlr3 {
 
@@ -77,6 +78,29 @@ public:
     virtual void rewind() = 0;
 };
 
+/// Lightweight stream position returned by IntStream::checkpoint().
+/// Streams that can seek back freely store just the index; streams that
+/// need to pin buffered input also carry a marker.
+class Checkpoint
+{
+public:
+    Checkpoint()
+        : index_()
+        , marker_()
+    {}
+
+    explicit Checkpoint(Index index, MarkerPtr marker = MarkerPtr())
+        : index_(index)
+        , marker_(std::move(marker))
+    {}
+
+    Index index() const { return index_; }
+    MarkerPtr const & marker() const { return marker_; }
+private:
+    Index index_;
+    MarkerPtr marker_;
+};
+
 class IntStream
 {
 public:
@@ -97,7 +121,7 @@ public:
 
     /// Get Item at current input pointer + i ahead.
     /// @sa LA().
-    virtual ItemPtr LI(std::int32_t i) = 0;
+    virtual Item LI(std::int32_t i) = 0;
 
     /// Tell the stream to start buffering if it hasn't already.
     /// Returns opaque position marker.
@@ -110,6 +134,14 @@ public:
     /// object.
     /// Calling mark()->rewind() should not affect the input cursor.
     virtual MarkerPtr mark() = 0;
+
+    /// Cheap alternative to mark() for short-lived positions, such as
+    /// those taken by predictions and syntactic predicates.
+    /// Default implementation falls back to mark().
+    virtual Checkpoint checkpoint() { return Checkpoint(index(), mark()); }
+
+    /// Returns to the position captured by checkpoint().
+    virtual void restore(Checkpoint const & cp) { cp.marker()->rewind(); }
     
     /// Return the current input symbol index 0..n where n indicates the
     /// last symbol has been read.
@@ -0,0 +1,103 @@
+/** \file
+ * Defines the value type used to pass current input symbols around
+ * without committing to the kind of the input stream.
+ */
+#ifndef _ANTLR3_ITEM_HPP
+#define _ANTLR3_ITEM_HPP
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/Defs.hpp>
+
+namespace antlr3 {
+
+/// Input symbol returned by IntStream::LI().
+///
+/// Character streams produce characters, which are stored inline without any allocation.
+/// Token and tree node streams produce shared pointers to tokens or nodes.
+///
+/// Tokens and nodes are owned rather than referenced by a raw pointer, so LI(), match()
+/// and currentInputSymbol() still update their reference counts. An item can outlive the
+/// stream's hold on its token: labels and Exception::item keep it after CommonTokenStream::release()
+/// has dropped consumed tokens, and CompactTokenStream only keeps its last few LT() results.
+/// Tree nodes are type-erased ItemPtr, which cannot be recovered from a raw pointer for
+/// labels and adaptor calls.
+class Item
+{
+public:
+    Item()
+        : ptr_()
+        , char_(CharstreamEof)
+        , isChar_(false)
+    {}
+
+    Item(std::nullptr_t)
+        : Item()
+    {}
+
+    template<class T>
+    Item(SharedPtr<T> ptr)
+        : ptr_(std::move(ptr))
+        , char_(CharstreamEof)
+        , isChar_(false)
+    {}
+
+    static Item fromChar(Char c)
+    {
+        Item retVal;
+        retVal.char_ = c;
+        retVal.isChar_ = true;
+        return retVal;
+    }
+
+    /// Returns true if item holds a character rather than a pointer.
+    bool isChar() const { return isChar_; }
+
+    /// Character value, CharstreamEof if item does not hold a character.
+    Char toChar() const { return char_; }
+
+    /// Pointer value, null if item holds a character.
+    ItemPtr const & ptr() const { return ptr_; }
+
+    explicit operator bool() const { return isChar_ || ptr_ != nullptr; }
+private:
+    ItemPtr ptr_;
+    Char char_;
+    bool isChar_;
+};
+
+template<class T> inline T pointer_cast(Item const & item)
+{
+    return pointer_cast<T>(item.ptr());
+}
+
+} // namespace antlr3
+
+#endif // _ANTLR3_ITEM_HPP
@@ -43,6 +43,8 @@ namespace antlr3 {
 
 Lexer::Lexer(RecognizerSharedStatePtr state)
     : BaseRecognizer(state)
+    , tokenFactory_()
+    , skipChars_()
 {
 }
 
@@ -102,12 +104,19 @@ CommonTokenPtr Lexer::nextTokenStr() {
             }
         }
         
+        // Runs of skipped characters do not need a rule to match them
+        if (!skipChars_.empty())
+        {
+            static_cast<CharStream *>(input_.get())->skipChars(skipChars_);
+        }
+
         if (input_->LA(1) == CharstreamEof)
         {
             // Reached the end of the current stream, nothing more to do if this is
             // the last in the stack.
             //
-            CommonTokenPtr teof = std::make_shared<CommonToken>(TokenEof);
+            CommonTokenPtr teof = newToken();
+            teof->setType(TokenEof);
             teof->setInputStream(charStream());
             teof->setStartIndex(charIndex());
             teof->setStopIndex(charIndex());
@@ -124,9 +133,15 @@ CommonTokenPtr Lexer::nextTokenStr() {
         state_->channel = TokenDefaultChannel;
         state_->tokenStartCharIndex	= charStream()->index();
         state_->text = ANTLR3_T("");
+
+        // Streams that discard consumed input must keep the token text until it is emitted
+        MarkerPtr tokenStart;
+        if (!charStream()->retainsInput()) {
+            tokenStart = input_->mark();
+        }
         
         if (filteringMode_) {
-            antlr3::MarkerPtr m = input_->mark();
+            antlr3::Checkpoint start = input_->checkpoint();
             state_->backtracking = 1; // No exceptions
 
             // Call the generated lexer, see if it can get a new token together.
@@ -139,7 +154,7 @@ CommonTokenPtr Lexer::nextTokenStr() {
             if (state_->failed)
             {
                 // Advance one char and try again
-                m->rewind();
+                input_->restore(start);
                 input_->consume();
                 continue;
             }
@@ -159,6 +174,14 @@ CommonTokenPtr Lexer::nextTokenStr() {
 
         if (state_->tokenBuffer.empty())
         {
+            if (state_->type == TokenInvalid)
+            {
+                // Skipped, there is no need to build a token only to discard it
+                state_->channel = TokenDefaultChannel;
+                state_->text.clear();
+                continue;
+            }
+
             // Emit the real token, which adds it in to the token stream basically
             emit();
         }
@@ -253,8 +276,8 @@ void Lexer::fillException(Exception* ex)
     ex->streamName	= input_->sourceName();
 }
 
-std::uint32_t Lexer::itemToInt(ItemPtr item) {
-    return CharStream::charFromItem(item);
+std::uint32_t Lexer::itemToInt(Item const & item) {
+    return item.toChar();
 }
 
 static String getCharErrorDisplay(Char c)
@@ -280,7 +303,7 @@ String Lexer::getErrorMessage(Exception const * e, ConstString const * tokenName
 //        }
         virtual void visit(MismatchedTokenException const * e) override
         {
-            retVal = ANTLR3_T("mismatched character ") + getCharErrorDisplay(CharStream::charFromItem(e->item)) +
+            retVal = ANTLR3_T("mismatched character ") + getCharErrorDisplay(e->item.toChar()) +
                      ANTLR3_T(", expecting ") + getCharErrorDisplay(e->expecting);
         }
         virtual void visit(NoViableAltException const * e) override
@@ -288,18 +311,18 @@ String Lexer::getErrorMessage(Exception const * e, ConstString const * tokenName
             // for development, can add "decision=<<"+nvae.grammarDecisionDescription+">>"
             // and "(decision="+nvae.decisionNumber+") and
             // "state "+nvae.stateNumber
-            Char c = (Char)reinterpret_cast<size_t>(e->item.get());
+            Char c = e->item.toChar();
             retVal = ANTLR3_T("no viable alternative at character ")+ getCharErrorDisplay(c);
         }
         virtual void visit(MismatchedSetException const * e) override
         {
-            Char c = (Char)reinterpret_cast<size_t>(e->item.get());
+            Char c = e->item.toChar();
             retVal = ANTLR3_T("mismatched character ") + getCharErrorDisplay(c) +
                      ANTLR3_T(", expecting set ") + getCharSetErrorDisplay(e->expectingSet);
         }
         virtual void visit(MismatchedRangeException const * e) override
         {
-            retVal = ANTLR3_T("mismatched character ") + getCharErrorDisplay(CharStream::charFromItem(e->item)) +
+            retVal = ANTLR3_T("mismatched character ") + getCharErrorDisplay(e->item.toChar()) +
                      ANTLR3_T(", expecting range ") + getCharErrorDisplay(e->low) +
                      ANTLR3_T("..") + getCharErrorDisplay(e->high);
         }
@@ -307,7 +330,7 @@ String Lexer::getErrorMessage(Exception const * e, ConstString const * tokenName
         {
             // for development, can add "(decision="+eee.decisionNumber+")"
             retVal = ANTLR3_T("required (...)+ loop did not match anything at character ") +
-                     getCharErrorDisplay(CharStream::charFromItem(e->item));
+                     getCharErrorDisplay(e->item.toChar());
         }
         virtual void visit(FailedPredicateException const * e) override
         {
@@ -319,7 +342,7 @@ String Lexer::getErrorMessage(Exception const * e, ConstString const * tokenName
         }
         virtual void visit(UnwantedTokenException const * e) override
         {
-            retVal = ANTLR3_T("extraneous character ") + getCharErrorDisplay(CharStream::charFromItem(e->item));
+            retVal = ANTLR3_T("extraneous character ") + getCharErrorDisplay(e->item.toChar());
         }
         virtual void visit(MissingTokenException const * e) override
         {
@@ -419,7 +442,7 @@ CommonTokenPtr Lexer::emit()
     * so we are not checking any errors. So make sure you have installed an input stream before
     * trying to emit a new token.
     */
-    CommonTokenPtr token = std::make_shared<CommonToken>();
+    CommonTokenPtr token = newToken();
 
     /* Install the supplied information, and some other bits we already know
     * get added automatically, such as the input stream it is associated with
@@ -435,6 +458,10 @@ CommonTokenPtr Lexer::emit()
     {
         token->setText(state_->text);
     }
+    else if (!charStream()->retainsInput())
+    {
+        token->setText(text());
+    }
     
     state_->type = TokenInvalid;
     state_->channel = TokenDefaultChannel;
@@ -445,11 +472,38 @@ CommonTokenPtr Lexer::emit()
     return token;
 }
 
+void Lexer::skip()
+{
+    state_->type = TokenInvalid;
+}
+
+void Lexer::setSkipChars(AsciiSet set)
+{
+    skipChars_ = set;
+}
+
+TokenFactoryPtr Lexer::tokenFactory() const
+{
+    return tokenFactory_;
+}
+
+void Lexer::setTokenFactory(TokenFactoryPtr factory)
+{
+    tokenFactory_ = std::move(factory);
+}
+
+CommonTokenPtr Lexer::newToken()
+{
+    if (tokenFactory_)
+    {
+        return tokenFactory_->newToken();
+    }
+    return makeShared<CommonToken>();
+}
+
 bool Lexer::matchs(char const * string, size_t len)
 {
-    // Default char may be both signed and unsigned.
-    // Cast it to unsigned to be sure.
-    return matchStr(reinterpret_cast<unsigned char const *>(string), len);
+    return matchStr(string, len);
 }
     
 bool Lexer::matchs(char16_t const * string, size_t len)
@@ -464,8 +518,20 @@ bool Lexer::matchs(char32_t const * string, size_t len)
     
 template<class T>
 bool Lexer::matchStr(T const * string, size_t len) {
+    // Whole literal at once, if the stream can compare its buffer
+    //
+    if (static_cast<CharStream *>(input_.get())->consumeLiteral(string, len)) {
+        state_->failed = false;
+        return true;
+    }
+
+    // Otherwise, or to report the mismatch, character by character.
+    // Default char may be both signed and unsigned.
+    // Cast it to unsigned to be sure.
+    //
+    typedef typename std::make_unsigned<T>::type Unit;
     for (size_t i = 0; i < len; ++i) {
-        if (!matchc(string[i])) {
+        if (!matchc(Unit(string[i]))) {
             return false;
         }
     }
@@ -546,6 +612,16 @@ String Lexer::text()
     return charStream()->substr(state_->tokenStartCharIndex, charIndex());
 }
     
+StringView Lexer::textView()
+{
+    if (!state_->text.empty())
+    {
+        return StringView(state_->text);
+    }
+
+    return charStream()->textView(state_->tokenStartCharIndex, charIndex());
+}
+
 void Lexer::setText(String s)
 {
     state_->text = std::move(s);
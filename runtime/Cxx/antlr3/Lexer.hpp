@@ -66,6 +66,7 @@
 #include <antlr3/CharStream.hpp>
 #include <antlr3/CommonToken.hpp>
 #include <antlr3/TokenStream.hpp>
+#include <antlr3/TokenFactory.hpp>
 #include <antlr3/BaseRecognizer.hpp>
 
 namespace antlr3 {
@@ -105,6 +106,22 @@ public:
      */
     virtual CommonTokenPtr emit();
 
+    /// Returns factory used to create tokens, null if tokens are allocated individually.
+    TokenFactoryPtr tokenFactory() const;
+
+    /// Sets factory used by emit() and at the end of input to create tokens.
+    /// Use PooledTokenFactory to recycle token memory between parses.
+    void setTokenFactory(TokenFactoryPtr factory);
+
+    /// Makes the rule being matched produce no token; no token object is created for it.
+    void skip();
+
+    /// Sets characters that are skipped in bulk before each token, without running
+    /// any rule. Generated lexers set it when a rule only skips a run of such
+    /// characters and no other token can start with them, and in filter mode
+    /// to the characters that cannot start any token.
+    void setSkipChars(AsciiSet set);
+
     /** Pointer to the user provided (either manually or through code generation
      *  function that causes the lexer rules to run the lexing rules and produce 
      *  the next token if there iss one. This is called from nextToken() in the
@@ -154,20 +171,120 @@ public:
 
     /// Return the text so far for the current token being generated
     String	text();
+
+    /// Return the text so far for the current token without copying it,
+    /// or a null view if the input stream cannot provide one.
+    StringView textView();
 protected:
     /// Set the complete text of this token; it wipes any previous changes to the text.
     void setText(String s);
     virtual void fillException(Exception* e) override;
-    virtual std::uint32_t itemToInt(ItemPtr item) override;
+    virtual std::uint32_t itemToInt(Item const & item) override;
     virtual String getErrorMessage(Exception const * e, ConstString const * tokenNames) override;
     virtual String traceCurrentItem() override;
 private:
+    TokenFactoryPtr tokenFactory_;
+    AsciiSet skipChars_;
+
     CommonTokenPtr nextTokenStr();
+    CommonTokenPtr newToken();
     
     template<class T>
     bool matchStr(T const * string, size_t len);
 };
 
+/** Lexer bound to a concrete character stream type.
+ *
+ *  Lexer reads characters through the virtual IntStream interface. BasicLexer
+ *  hides LA(), matchc(), matchRange(), matchs() and matchAny() with versions that
+ *  call non-virtual peek() and advance() of \a Stream, so in generated code they
+ *  are inlined down to pointer compares and increments. The input must be a
+ *  \a Stream, or derived from it without changing how characters are read.
+ *  Errors are still reported by Lexer.
+ *
+ *  Generated lexers use it when it is given as the superClass option:
+ *  \code
+ *  options { superClass = 'antlr3::BasicLexer<antlr3::ByteCharStream>'; }
+ *  \endcode
+ */
+template<class Stream>
+class BasicLexer : public Lexer
+{
+public:
+    BasicLexer(RecognizerSharedStatePtr state)
+        : Lexer(std::move(state))
+    {}
+
+    BasicLexer(CharStreamPtr input, RecognizerSharedStatePtr state)
+        : Lexer(input, std::move(state))
+    {
+        assert(!input || dynamic_cast<Stream *>(input.get()));
+    }
+
+    std::uint32_t LA(std::int32_t i)
+    {
+        return i > 0 ? stream()->peek(i) : input_->LA(i);
+    }
+
+    bool matchs(char const * string, size_t len) { return matchStr(string, len); }
+    bool matchs(char16_t const * string, size_t len) { return matchStr(string, len); }
+    bool matchs(char32_t const * string, size_t len) { return matchStr(string, len); }
+
+    template<class CharT, size_t N>
+    bool matchs(CharT const (&string)[N]) {
+        static_assert(N > 0, "Null-terminated literal cannot be empty");
+        assert(!string[N - 1]);
+        return matchs(string, N - 1);
+    }
+
+    bool matchc(Char c)
+    {
+        return matchRange(c, c);
+    }
+
+    bool matchRange(Char low, Char high)
+    {
+        Char c = stream()->peek(1);
+        if (c >= low && c <= high)
+        {
+            stream()->advance();
+            state_->failed = false;
+            return true;
+        }
+
+        // Let the generic implementation report the mismatch
+        //
+        return Lexer::matchRange(low, high);
+    }
+
+    void matchAny()
+    {
+        stream()->advance();
+    }
+protected:
+    Stream * stream()
+    {
+        return static_cast<Stream *>(input_.get());
+    }
+private:
+    template<class T>
+    bool matchStr(T const * string, size_t len)
+    {
+        if (stream()->Stream::consumeLiteral(string, len)) {
+            state_->failed = false;
+            return true;
+        }
+
+        typedef typename std::make_unsigned<T>::type Unit;
+        for (size_t i = 0; i < len; ++i) {
+            if (!matchc(Unit(string[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
 } // namespace antlr3
 
 #endif
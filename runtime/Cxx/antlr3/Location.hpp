@@ -117,6 +117,11 @@ public:
     /// Returns subtring from start to stop in UTF-8 encoding.
     /// @todo: Clarify interpretation of the stop: is it over-the-end pointer or pointer to first code unit of the last character
     virtual String substr(Index start, Index stop) = 0;
+
+    /// Returns text from start to stop without copying it, or a null view
+    /// if the source cannot provide a contiguous range of String code units.
+    /// Default implementation always returns a null view.
+    virtual StringView textView(Index, Index) { return StringView(); }
 };
 
 } // namespace antlr3
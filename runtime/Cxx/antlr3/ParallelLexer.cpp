@@ -0,0 +1,192 @@
+/** \file
+ * Implementation of the parallel chunked lexer.
+ */
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/ParallelLexer.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+namespace antlr3 {
+
+ParallelLexer::ParallelLexer(CharStreamPtr input, std::uint8_t const * data, Index size, ChunkFactory chunkFactory,
+                             LexerFactory factory, SplitFunction split, std::size_t chunks)
+    : TokenSource()
+    , input_(std::move(input))
+    , data_(data)
+    , size_(size)
+    , chunkFactory_(std::move(chunkFactory))
+    , factory_(std::move(factory))
+    , split_(std::move(split))
+    , chunks_(chunks)
+    , offsets_()
+    , tokens_()
+    , next_(NullIndex)
+{
+    // Chunk streams take 32-bit sizes
+    //
+    assert(size_ <= 0xFFFFFFFF);
+
+    if (chunks_ == 0) {
+        chunks_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+ParallelLexer::~ParallelLexer()
+{
+}
+
+CommonTokenPtr ParallelLexer::nextToken()
+{
+    if (next_ == NullIndex) {
+        lex();
+        next_ = 0;
+    }
+
+    // Keep returning EOF once the input is exhausted
+    //
+    if (next_ + 1 < tokens_.size()) {
+        return tokens_[next_++];
+    }
+    return tokens_.back();
+}
+
+LocationSourcePtr ParallelLexer::source()
+{
+    return input_;
+}
+
+Index ParallelLexer::splitAfterNewline(std::uint8_t const * data, Index size, Index pos)
+{
+    void const * newline = memchr(data + pos, '\n', size - pos);
+    if (newline == nullptr) {
+        return size;
+    }
+    return static_cast<std::uint8_t const *>(newline) - data + 1;
+}
+
+void ParallelLexer::lex()
+{
+    // Find the chunk boundaries, chunks that would be empty are merged into the previous one
+    //
+    offsets_.assign(1, 0);
+    for (std::size_t k = 1; k < chunks_; ++k) {
+        Index pos = std::max(offsets_.back() + 1, size_ / chunks_ * k);
+        if (pos >= size_) {
+            break;
+        }
+        pos = split_(data_, size_, pos);
+        if (pos >= size_) {
+            break;
+        }
+        offsets_.push_back(pos);
+    }
+
+    std::vector<std::vector<CommonTokenPtr>> chunkTokens(offsets_.size());
+    std::vector<std::exception_ptr> errors(offsets_.size());
+#if ANTLR3_SINGLE_THREADED
+    // Reference counts are not atomic, so tokens must not cross threads
+    //
+    for (std::size_t k = 0; k < offsets_.size(); ++k) {
+        lexChunk(k, chunkTokens[k], errors[k]);
+    }
+#else
+    std::vector<std::thread> threads;
+    for (std::size_t k = 1; k < offsets_.size(); ++k) {
+        threads.emplace_back(&ParallelLexer::lexChunk, this, k, std::ref(chunkTokens[k]), std::ref(errors[k]));
+    }
+    lexChunk(0, chunkTokens[0], errors[0]);
+    for (std::thread & t : threads) {
+        t.join();
+    }
+#endif
+
+    // Report the error of the earliest chunk, as lexing the whole input would
+    //
+    for (std::exception_ptr const & error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::size_t count = 0;
+    for (auto const & tokens : chunkTokens) {
+        count += tokens.size();
+    }
+    tokens_.reserve(count);
+    for (auto & tokens : chunkTokens) {
+        std::move(tokens.begin(), tokens.end(), std::back_inserter(tokens_));
+    }
+}
+
+void ParallelLexer::lexChunk(std::size_t chunk, std::vector<CommonTokenPtr> & tokens, std::exception_ptr & error)
+{
+    // Exceptions must not escape worker threads, they are rethrown by lex()
+    //
+    try {
+        lexChunkTokens(chunk, tokens);
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+}
+
+void ParallelLexer::lexChunkTokens(std::size_t chunk, std::vector<CommonTokenPtr> & tokens)
+{
+    Index offset = offsets_[chunk];
+    Index end = chunk + 1 < offsets_.size() ? offsets_[chunk + 1] : size_;
+    bool last = chunk + 1 == offsets_.size();
+
+    TokenSourcePtr lexer = factory_(chunkFactory_(data_ + offset, end - offset));
+    for (;;) {
+        CommonTokenPtr token = lexer->nextToken();
+        bool eof = token->type() == TokenEof;
+
+        // Only the EOF of the whole input is kept
+        //
+        if (eof && !last) {
+            break;
+        }
+
+        token->setStartIndex(token->startIndex() + offset);
+        token->setStopIndex(token->stopIndex() + offset);
+        token->setInputStream(input_);
+        tokens.push_back(std::move(token));
+
+        if (eof) {
+            break;
+        }
+    }
+}
+
+} // namespace antlr3
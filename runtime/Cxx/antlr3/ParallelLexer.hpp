@@ -0,0 +1,132 @@
+/** \file
+ * Defines a token source that lexes chunks of a single input in parallel.
+ */
+#ifndef _ANTLR3_PARALLELLEXER_HPP
+#define _ANTLR3_PARALLELLEXER_HPP
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/TokenStream.hpp>
+#include <exception>
+#include <functional>
+#include <vector>
+
+namespace antlr3 {
+
+/** Token source that splits byte input into chunks and lexes them
+ *  on separate threads, each with its own lexer instance.
+ *
+ *  The input is split at safe points found by a split function. A safe point
+ *  must be a position where the lexer starts in its initial state, for example
+ *  a newline outside of strings and comments, so that lexing chunks separately
+ *  gives the same tokens as lexing the whole input. Only the grammar author
+ *  can tell where such points are, so the function is supplied by the user;
+ *  splitAfterNewline() is enough for line-oriented formats.
+ *
+ *  Tokens of all chunks are returned in order as if produced by a single lexer:
+ *  character offsets are rebased onto the original input, which the tokens then
+ *  refer to, and only the EOF token of the last chunk is kept.
+ *  Token indices are assigned by the token stream as usual, so the source can
+ *  be passed to CommonTokenStream directly.
+ *
+ *  All chunks are lexed on the first call to nextToken(). When the runtime is
+ *  built with ANTLR3_SINGLE_THREADED, chunks are lexed one after another on
+ *  the calling thread. An exception thrown while lexing a chunk is rethrown
+ *  from nextToken() once all chunks are done.
+ *
+ *  Input must be smaller than 4GB, same as for the character streams.
+ */
+class ParallelLexer : public TokenSource
+{
+public:
+    /// Creates a lexer for a chunk of input.
+    /// Called on worker threads, so it must not share state between lexers.
+    typedef std::function<TokenSourcePtr(CharStreamPtr input)> LexerFactory;
+
+    /// Returns the first safe point at or after \a pos in the input of \a size bytes,
+    /// or \a size if there is none.
+    typedef std::function<Index(std::uint8_t const * data, Index size, Index pos)> SplitFunction;
+
+    /** Creates source over a ByteCharStream or UTF8CharStream.
+     *  \a chunks is the number of chunks and threads to use, zero means
+     *  the number of hardware threads.
+     */
+    template<class Stream>
+    ParallelLexer(SharedPtr<Stream> input, LexerFactory factory,
+                  SplitFunction split = splitAfterNewline, std::size_t chunks = 0)
+        : ParallelLexer(input, input->data(), input->size(),
+                        [input](std::uint8_t const * data, Index size) -> CharStreamPtr {
+                            return makeShared<Stream>(data, std::uint32_t(size),
+                                [](std::uint8_t const *) {}, input->sourceName());
+                        },
+                        std::move(factory), std::move(split), chunks)
+    {}
+
+    ~ParallelLexer();
+
+    virtual CommonTokenPtr nextToken() override;
+    virtual LocationSourcePtr source() override;
+
+    /// Offsets at which chunks start, available after the first nextToken().
+    std::vector<Index> const & chunkOffsets() const { return offsets_; }
+
+    /// Split function that splits after the next '\n'.
+    static Index splitAfterNewline(std::uint8_t const * data, Index size, Index pos);
+private:
+    typedef std::function<CharStreamPtr(std::uint8_t const * data, Index size)> ChunkFactory;
+
+    ParallelLexer(CharStreamPtr input, std::uint8_t const * data, Index size, ChunkFactory chunkFactory,
+                  LexerFactory factory, SplitFunction split, std::size_t chunks);
+
+    void lex();
+    void lexChunk(std::size_t chunk, std::vector<CommonTokenPtr> & tokens, std::exception_ptr & error);
+    void lexChunkTokens(std::size_t chunk, std::vector<CommonTokenPtr> & tokens);
+
+    CharStreamPtr input_;
+    std::uint8_t const * data_;
+    Index size_;
+    ChunkFactory chunkFactory_;
+    LexerFactory factory_;
+    SplitFunction split_;
+    std::size_t chunks_;
+
+    /// Start offset of each chunk, the chunk ends where the next one starts.
+    std::vector<Index> offsets_;
+
+    /// Tokens of all chunks.
+    std::vector<CommonTokenPtr> tokens_;
+
+    /// Index of the next token to return, NullIndex before lexing.
+    Index next_;
+};
+
+} // namespace antlr3
+
+#endif
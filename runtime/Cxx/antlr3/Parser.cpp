@@ -77,7 +77,7 @@ ItemPtr Parser::getMissingSymbol(
 
     // Create a new empty token
     //
-    CommonTokenPtr token = std::make_shared<CommonToken>();
+    CommonTokenPtr token = makeShared<CommonToken>();
     token->setInputStream(current->inputStream());
 
     // Set some of the token properties based on the current token
@@ -119,8 +119,8 @@ void Parser::fillException(Exception* ex)
     }
 }
 
-std::uint32_t Parser::itemToInt(ItemPtr item) {
-    return std::static_pointer_cast<CommonToken>(item)->type();
+std::uint32_t Parser::itemToInt(Item const & item) {
+    return pointer_cast<CommonTokenPtr>(item)->type();
 }
 
 void Parser::setDebugListener(DebugEventListenerPtr dbg)
@@ -141,7 +141,7 @@ void Parser::setDebugListener(DebugEventListenerPtr dbg)
     //
     if	(input_ != NULL)
     {
-        setTokenStream(std::make_shared<DebugTokenStream>(tokenStream(), debugger_));
+        setTokenStream(makeShared<DebugTokenStream>(tokenStream(), debugger_));
     }
 }
 
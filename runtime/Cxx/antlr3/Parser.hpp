@@ -74,7 +74,7 @@ protected:
     }
     
     virtual void fillException(Exception* ex) override;
-    virtual std::uint32_t itemToInt(ItemPtr item) override;
+    virtual std::uint32_t itemToInt(Item const & item) override;
     virtual String traceCurrentItem() override;
 };
 
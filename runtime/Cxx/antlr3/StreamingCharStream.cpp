@@ -0,0 +1,323 @@
+/** \file
+ * Implementation of the bounded-memory streaming character stream.
+ */
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/StreamingCharStream.hpp>
+#include <istream>
+
+#if defined(_WIN64) || defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace antlr3 {
+
+namespace {
+
+StreamingCharStream::Reader fdReader(int fd)
+{
+    return [fd](std::uint8_t * buffer, std::size_t size) -> std::size_t {
+        for (;;) {
+#if defined(_WIN64) || defined(_WIN32)
+            int n = ::_read(fd, buffer, (unsigned)std::min<std::size_t>(size, 0x7FFFFFFF));
+            if (n >= 0) {
+                return std::size_t(n);
+            }
+            return 0;
+#else
+            ssize_t n = ::read(fd, buffer, size);
+            if (n >= 0) {
+                return std::size_t(n);
+            }
+            if (errno != EINTR) {
+                return 0;
+            }
+#endif
+        }
+    };
+}
+
+StreamingCharStream::Reader istreamReader(std::istream & stream)
+{
+    std::istream * s = &stream;
+    return [s](std::uint8_t * buffer, std::size_t size) -> std::size_t {
+        // Return whatever is available, but block for at least one byte
+        // so that interactive inputs are not stalled until a full chunk arrives.
+        s->read(reinterpret_cast<char *>(buffer), 1);
+        if (s->gcount() == 0) {
+            return 0;
+        }
+        std::streamsize n = s->readsome(reinterpret_cast<char *>(buffer) + 1, std::streamsize(size - 1));
+        return 1 + std::size_t(std::max<std::streamsize>(n, 0));
+    };
+}
+
+} // namespace
+
+StreamingCharStream::StreamingCharStream(Reader reader, String name, std::size_t chunkSize)
+    : CharStream()
+    , reader_(std::move(reader))
+    , streamName_(std::move(name))
+    , chunkSize_(std::max<std::size_t>(chunkSize, 1))
+    , chunks_()
+    , firstChunk_(0)
+    , end_(0)
+    , eof_(false)
+    , pos_(0)
+    , lastPos_(0)
+    , lines_({0})
+    , firstLine_(1)
+    , newlineChar_('\n')
+{
+}
+
+StreamingCharStream::StreamingCharStream(int fd, String name, std::size_t chunkSize)
+    : StreamingCharStream(fdReader(fd), std::move(name), chunkSize)
+{
+}
+
+StreamingCharStream::StreamingCharStream(std::istream & stream, String name, std::size_t chunkSize)
+    : StreamingCharStream(istreamReader(stream), std::move(name), chunkSize)
+{
+}
+
+StreamingCharStream::~StreamingCharStream()
+{
+}
+
+String StreamingCharStream::sourceName()
+{
+    return streamName_;
+}
+
+bool StreamingCharStream::fill(Index index)
+{
+    while (index >= end_) {
+        if (eof_) {
+            return false;
+        }
+
+        if (chunks_.empty() || chunks_.back()->size() == chunkSize_) {
+            // Released chunks are not reused: they may still be pinned by markers
+            auto chunk = makeShared<Chunk>();
+            chunk->reserve(chunkSize_);
+            if (chunks_.empty()) {
+                firstChunk_ = end_ / chunkSize_;
+            }
+            chunks_.push_back(std::move(chunk));
+        }
+
+        Chunk & chunk = *chunks_.back();
+        std::size_t used = chunk.size();
+        chunk.resize(chunkSize_);
+        std::size_t n = reader_(chunk.data() + used, chunkSize_ - used);
+        chunk.resize(used + n);
+        if (n == 0) {
+            eof_ = true;
+        }
+        end_ += n;
+    }
+    return true;
+}
+
+std::uint8_t StreamingCharStream::at(Index index) const
+{
+    assert(index >= windowStart() && index < end_);
+    Chunk const & chunk = *chunks_[index / chunkSize_ - firstChunk_];
+    return chunk[index % chunkSize_];
+}
+
+void StreamingCharStream::release()
+{
+    // Keep the character before the current position available for LA(-1)
+    if (pos_ == 0) {
+        return;
+    }
+    Index keep = pos_ - 1;
+    while (chunks_.size() > 1 && (firstChunk_ + 1) * chunkSize_ <= keep && chunks_.front().use_count() == 1) {
+        chunks_.pop_front();
+        ++firstChunk_;
+    }
+
+    Index start = windowStart();
+    while (lines_.size() > 1 && lines_[1] <= start) {
+        lines_.pop_front();
+        ++firstLine_;
+    }
+}
+
+void StreamingCharStream::consume()
+{
+    if (!fill(pos_)) {
+        return;
+    }
+
+    std::uint8_t c = at(pos_);
+    ++pos_;
+    if (pos_ > lastPos_) {
+        lastPos_ = pos_;
+        if (c == newlineChar_) {
+            lines_.push_back(pos_);
+        }
+    }
+
+    if (pos_ % chunkSize_ == 0) {
+        release();
+    }
+}
+
+std::uint32_t StreamingCharStream::LA(std::int32_t i)
+{
+    if (i > 0)
+    {
+        Index index = pos_ + (i - 1);
+        if (fill(index))
+        {
+            return at(index);
+        }
+        return CharstreamEof;
+    }
+    else if (i < 0)
+    {
+        if (Index(-i) <= pos_)
+        {
+            Index index = pos_ + i;
+            if (index >= windowStart())
+            {
+                return at(index);
+            }
+            assert(false && "Character has been discarded");
+        }
+        return CharstreamEof;
+    }
+    else
+    {
+        assert(false);
+        return CharstreamEof;
+    }
+}
+
+MarkerPtr StreamingCharStream::mark()
+{
+    fill(pos_);
+    ChunkPtr chunk;
+    if (!chunks_.empty()) {
+        Index n = std::min<Index>(pos_ / chunkSize_ - firstChunk_, chunks_.size() - 1);
+        chunk = chunks_[n];
+    }
+    return makeShared<StreamMarker>(pos_, std::move(chunk), shared_from_this());
+}
+
+Index StreamingCharStream::index()
+{
+    return pos_;
+}
+
+void StreamingCharStream::seek(Index index)
+{
+    if (index <= pos_) {
+        assert(index >= windowStart() && "Cannot seek to discarded input");
+        pos_ = index;
+        return;
+    }
+    while (pos_ < index && LA(1) != CharstreamEof) {
+        consume();
+    }
+}
+
+// CharStream
+
+Location StreamingCharStream::location(Index index)
+{
+    if (index < lines_.front()) {
+        // Line start has been discarded
+        return Location();
+    }
+    if (index > lastPos_) {
+        assert(false && "Should not access locations in not read area");
+        index = lastPos_;
+    }
+    auto it = std::upper_bound(lines_.begin(), lines_.end(), index);
+    assert(it > lines_.begin());
+    --it;
+    std::size_t line = firstLine_ + (it - lines_.begin());
+    std::size_t charPos = index - *it;
+    return Location(std::uint32_t(line), std::uint32_t(1 + charPos));
+}
+
+String StreamingCharStream::substr(Index start, Index stop)
+{
+    if (start < windowStart() || stop > end_) {
+        assert(false && "Text has been discarded");
+        return String();
+    }
+
+    String retVal;
+    retVal.reserve(stop - start);
+    for (Index i = start; i < stop; ) {
+        Chunk const & chunk = *chunks_[i / chunkSize_ - firstChunk_];
+        std::size_t offset = i % chunkSize_;
+        std::size_t n = std::min<std::size_t>(chunk.size() - offset, stop - i);
+        retVal.append(chunk.begin() + offset, chunk.begin() + offset + n);
+        i += n;
+    }
+    return retVal;
+}
+
+bool StreamingCharStream::retainsInput()
+{
+    return false;
+}
+
+Index StreamingCharStream::windowStart() const
+{
+    return firstChunk_ * chunkSize_;
+}
+
+std::size_t StreamingCharStream::bufferedSize() const
+{
+    return end_ - windowStart();
+}
+
+std::uint8_t StreamingCharStream::newLineChar() const
+{
+    return newlineChar_;
+}
+
+void StreamingCharStream::setNewLineChar(std::uint8_t newlineChar)
+{
+    newlineChar_ = newlineChar;
+}
+
+} // namespace antlr3
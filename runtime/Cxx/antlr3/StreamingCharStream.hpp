@@ -0,0 +1,170 @@
+/** \file
+ * Defines a character stream that reads its input incrementally from a file
+ * descriptor, std::istream or any other reader, keeping only a bounded window
+ * of the input in memory.
+ */
+#ifndef _ANTLR3_STREAMING_CHARSTREAM_HPP
+#define _ANTLR3_STREAMING_CHARSTREAM_HPP
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/CharStream.hpp>
+#include <deque>
+#include <iosfwd>
+
+namespace antlr3 {
+
+/// Byte character stream for inputs that cannot or should not be loaded into memory
+/// as a whole, such as pipes, sockets or never-ending log feeds.
+///
+/// Input is read in fixed size chunks on demand. Chunks that are behind both the current
+/// position and every live marker are released, so memory usage is proportional
+/// to the lookahead and backtracking distance rather than to the input size.
+///
+/// Consequences of discarding consumed input:
+/// * substr() works only for ranges that are still buffered. Lexer copies token text eagerly
+///   for such streams (see CharStream::retainsInput()), so tokens do not refer back to the stream.
+/// * location() returns an invalid Location for positions before the first buffered line.
+/// * seek() can move backwards only within the buffered window.
+class StreamingCharStream : public CharStream, public EnableSharedFromThis<StreamingCharStream>
+{
+public:
+    /// Reads up to \a size bytes into \a buffer, returns number of bytes read.
+    /// Returning zero indicates end of input.
+    typedef std::function<std::size_t(std::uint8_t * buffer, std::size_t size)> Reader;
+
+    static std::size_t const DefaultChunkSize = 64 * 1024;
+
+    StreamingCharStream(Reader reader, String name, std::size_t chunkSize = DefaultChunkSize);
+
+    /// Reads from file descriptor \a fd. Descriptor is not closed by the stream.
+    StreamingCharStream(int fd, String name, std::size_t chunkSize = DefaultChunkSize);
+
+    /// Reads from \a stream, which must outlive the char stream.
+    StreamingCharStream(std::istream & stream, String name, std::size_t chunkSize = DefaultChunkSize);
+
+    ~StreamingCharStream() override;
+
+    // IntStream
+
+    virtual String sourceName() override;
+    virtual void consume() override;
+    virtual std::uint32_t LA(std::int32_t i) override;
+    virtual MarkerPtr mark() override;
+    virtual Index index() override;
+    virtual void seek(Index index) override;
+
+    // CharStream
+
+    virtual Location location(Index index) override;
+    virtual String substr(Index start, Index stop) override;
+    virtual bool retainsInput() override;
+
+    /// Returns index of the first character still held in memory.
+    Index windowStart() const;
+
+    /// Returns number of characters currently held in memory.
+    std::size_t bufferedSize() const;
+
+    /// Character that triggers line number increment, '\n' by default.
+    std::uint8_t newLineChar() const;
+    void setNewLineChar(std::uint8_t newlineChar);
+private:
+    typedef std::vector<std::uint8_t> Chunk;
+    typedef SharedPtr<Chunk> ChunkPtr;
+
+    class StreamMarker : public Marker
+    {
+    public:
+        StreamMarker(Index pos, ChunkPtr chunk, SharedPtr<StreamingCharStream> stream)
+            : Marker()
+            , pos_(pos)
+            , chunk_(std::move(chunk))
+            , stream_(std::move(stream))
+        {}
+
+        /// Position to rewind to.
+        Index pos_;
+        /// Pins the chunk containing pos_ and thus all chunks after it.
+        ChunkPtr chunk_;
+        SharedPtr<StreamingCharStream> stream_;
+
+        virtual void rewind() override {
+            stream_->pos_ = pos_;
+        }
+    };
+
+    /// Reads input until character at \a index is buffered.
+    /// Returns false if input ends before that.
+    bool fill(Index index);
+
+    /// Character at \a index, which must be buffered.
+    std::uint8_t at(Index index) const;
+
+    /// Discards chunks that are no longer reachable.
+    void release();
+
+    Reader reader_;
+
+    /// Stream name used for error reporting.
+    String streamName_;
+
+    std::size_t chunkSize_;
+
+    /// Buffered chunks, all but the last one are full.
+    std::deque<ChunkPtr> chunks_;
+
+    /// Ordinal number of chunks_.front() in the input.
+    Index firstChunk_;
+
+    /// Number of characters read from the reader so far.
+    Index end_;
+
+    /// Reader has reported end of input.
+    bool eof_;
+
+    /// Current position
+    Index pos_;
+
+    /// Last reached position, lines are known up to this point.
+    Index lastPos_;
+
+    /// Start offsets of buffered lines, lines_.front() is at or before windowStart().
+    std::deque<Index> lines_;
+
+    /// 1-based number of the line starting at lines_.front().
+    std::uint32_t firstLine_;
+
+    std::uint8_t newlineChar_;
+};
+
+} // namespace antlr3
+
+#endif // _ANTLR3_STREAMING_CHARSTREAM_HPP
@@ -45,14 +45,14 @@ namespace {
     template<> struct ConvertionFunc<char, char16_t> {
         template<class SrcIt, class DstIt>
         static void convert(SrcIt& sourceStart, SrcIt sourceEnd, DstIt& targetStart, DstIt targetEnd) {
-            utf::ConversionResult r = utf::Convert<utf::UTF8, utf::UTF16>(sourceStart, sourceEnd, targetStart, targetEnd, utf::ConversionFlags::LenientConversion);
+            utf::ConversionResult r = utf::ConvertBuffer<utf::UTF8, utf::UTF16>(sourceStart, sourceEnd, targetStart, targetEnd, utf::ConversionFlags::LenientConversion);
             assert(r == utf::ConversionResult::ConversionOK);
         }
     };
     template<> struct ConvertionFunc<char16_t, char> {
         template<class SrcIt, class DstIt>
         static void convert(SrcIt& sourceStart, SrcIt sourceEnd, DstIt& targetStart, DstIt targetEnd) {
-            utf::ConversionResult r = utf::Convert<utf::UTF16, utf::UTF8>(sourceStart, sourceEnd, targetStart, targetEnd, utf::ConversionFlags::LenientConversion);
+            utf::ConversionResult r = utf::ConvertBuffer<utf::UTF16, utf::UTF8>(sourceStart, sourceEnd, targetStart, targetEnd, utf::ConversionFlags::LenientConversion);
             assert(r == utf::ConversionResult::ConversionOK);
         }
     };
@@ -68,23 +68,34 @@ namespace {
         typedef typename UTFType<DstChar>::t DstT;
 
         size_t oldLen = dst.size();
+        auto srcStart = reinterpret_cast<SrcT const *>(src);
+        auto srcEnd = srcStart + len;
+
+        if (sizeof(DstT) >= sizeof(SrcT))
+        {
+            // Every source code unit produces at most one destination code unit,
+            // so the output fits into source length and is converted in a single pass.
+            dst.resize(oldLen + len);
+            auto dstBegin = reinterpret_cast<DstT *>(&dst[0]);
+            auto dstStart = dstBegin + oldLen;
+            ConvertionFunc<SrcChar, DstChar>::convert(srcStart, srcEnd, dstStart, dstStart + len);
+            dst.resize(dstStart - dstBegin);
+            return dst;
+        }
 
         // 1 - Dry run - determine needed dst size
         {
-            auto srcStart = reinterpret_cast<SrcT const *>(src);
-            auto srcEnd = srcStart + len;
+            auto srcDry = srcStart;
             utf::DummyWriteIterator<DstT> dstStart(0), dstEnd;
-            ConvertionFunc<SrcChar, DstChar>::convert(srcStart, srcEnd, dstStart, dstEnd);
+            ConvertionFunc<SrcChar, DstChar>::convert(srcDry, srcEnd, dstStart, dstEnd);
             size_t dstCapacity = dst.length() + dstStart.pos();
             dst.resize(dstCapacity);
         }
 
         // 2 - Actual conversion
         {
-            auto srcStart = reinterpret_cast<SrcT const *>(src);
-            auto srcEnd = srcStart + len;
             auto dstStart = reinterpret_cast<DstT *>(&dst[0] + oldLen);
-            auto dstEnd = dstStart - oldLen + dst.capacity();
+            auto dstEnd = reinterpret_cast<DstT *>(&dst[0] + dst.size());
             ConvertionFunc<SrcChar, DstChar>::convert(srcStart, srcEnd, dstStart, dstEnd);
         }
         return dst;
@@ -83,6 +83,62 @@ inline String& appendUTF8(String& s, char const * s8) { return s += s8; }
 
 #endif
 
+/// Non-owning reference to a range of String code units, used to access
+/// token text without copying it out of the input buffer.
+/// A default-constructed view is null, which is distinct from an empty one:
+/// it means that text is not available as a contiguous range.
+/// The view is valid only as long as the buffer it refers to.
+class StringView
+{
+public:
+    typedef String::value_type value_type;
+    typedef value_type const * const_iterator;
+
+    StringView() : data_(), size_() {}
+    StringView(value_type const * data, std::size_t size) : data_(data), size_(size) {}
+    StringView(String const & s) : data_(s.data()), size_(s.size()) {}
+
+    value_type const * data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool isNull() const { return data_ == nullptr; }
+
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+    value_type operator[](std::size_t i) const { return data_[i]; }
+
+    /// Copies viewed code units into a new string.
+    String str() const { return isNull() ? String() : String(data_, size_); }
+private:
+    value_type const * data_;
+    std::size_t size_;
+};
+
+inline bool operator==(StringView a, StringView b)
+{
+    return a.size() == b.size() && std::char_traits<StringView::value_type>::compare(a.data(), b.data(), a.size()) == 0;
+}
+
+inline bool operator!=(StringView a, StringView b) { return !(a == b); }
+
+/// Returns true if \a s consists of exactly the \a size ASCII characters in \a ascii.
+/// Generated lexers use it to classify keywords without building a String.
+inline bool equalsAscii(StringView s, char const * ascii, std::size_t size)
+{
+    if (s.size() != size)
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        if (s[i] != StringView::value_type(ascii[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 String toString(int val);
 String toString(long val);
 String toString(long long val);
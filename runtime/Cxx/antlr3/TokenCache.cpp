@@ -0,0 +1,210 @@
+/** \file
+ * Implementation of the binary token cache.
+ */
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/TokenCache.hpp>
+#include <cstring>
+#include <fstream>
+
+namespace antlr3 {
+
+namespace {
+
+char const Magic[8] = { 'A', 'N', 'T', 'L', 'R', '3', 'T', 'C' };
+
+/// Layout of the file:
+///   Header
+///   types, channels, starts, stops   - std::uint32_t[tokenCount] each
+///   TextEntry[textCount]
+///   UTF-8 text                       - textBytes bytes
+struct Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t tokenCount;
+    std::uint64_t inputHash;
+    std::uint32_t textCount;
+    std::uint32_t textBytes;
+};
+
+/// Overridden text of a token, as a slice of the text at the end of the file.
+struct TextEntry
+{
+    std::uint32_t index;
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+
+template<class T>
+void writeArray(std::ostream & out, std::vector<T> const & v)
+{
+    out.write(reinterpret_cast<char const *>(v.data()), v.size() * sizeof(T));
+}
+
+} // namespace
+
+std::uint64_t TokenCache::hash(void const * data, std::size_t size)
+{
+    std::uint8_t const * p = static_cast<std::uint8_t const *>(data);
+    std::uint64_t h = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool TokenCache::write(std::ostream & out, CommonTokenStream & stream, std::uint64_t inputHash)
+{
+    std::vector<CommonTokenPtr> tokens = stream.tokens();
+    std::size_t n = tokens.size();
+
+    // Stream that releases consumed tokens has only the tail of the input left
+    //
+    if (n == 0 || tokens[0]->tokenIndex() != 0) {
+        return false;
+    }
+
+    std::vector<std::uint32_t> types(n), channels(n), starts(n), stops(n);
+    std::vector<TextEntry> entries;
+    std::string text;
+    for (std::size_t i = 0; i < n; ++i) {
+        CommonToken const & token = *tokens[i];
+        assert(token.inputStream() == tokens[0]->inputStream());
+        assert(token.startIndex() <= 0xFFFFFFFF && token.stopIndex() <= 0xFFFFFFFF);
+
+        types[i] = token.type();
+        channels[i] = token.channel();
+        starts[i] = (std::uint32_t)token.startIndex();
+        stops[i] = (std::uint32_t)token.stopIndex();
+
+        if (token.hasText()) {
+            TextEntry entry;
+            entry.index = (std::uint32_t)i;
+            entry.offset = (std::uint32_t)text.size();
+            appendToUTF8(text, token.text());
+            entry.size = (std::uint32_t)(text.size() - entry.offset);
+            entries.push_back(entry);
+        }
+    }
+
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.tokenCount = (std::uint32_t)n;
+    header.inputHash = inputHash;
+    header.textCount = (std::uint32_t)entries.size();
+    header.textBytes = (std::uint32_t)text.size();
+
+    out.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    writeArray(out, types);
+    writeArray(out, channels);
+    writeArray(out, starts);
+    writeArray(out, stops);
+    writeArray(out, entries);
+    out.write(text.data(), text.size());
+    return bool(out);
+}
+
+bool TokenCache::write(char const * fileName, CommonTokenStream & stream, std::uint64_t inputHash)
+{
+    std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+    return out && write(out, stream, inputHash);
+}
+
+CompactTokenStreamPtr TokenCache::load(void const * data, std::size_t size, std::uint64_t inputHash,
+                                       LocationSourcePtr input, Index inputSize)
+{
+    assert(reinterpret_cast<std::uintptr_t>(data) % sizeof(std::uint32_t) == 0);
+
+    Header header;
+    if (size < sizeof(header)) {
+        return CompactTokenStreamPtr();
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version
+        || header.inputHash != inputHash || header.tokenCount == 0)
+    {
+        return CompactTokenStreamPtr();
+    }
+
+    // Reject truncated files before touching the arrays
+    //
+    std::size_t n = header.tokenCount;
+    std::size_t expected = sizeof(header) + 4 * n * sizeof(std::uint32_t)
+        + header.textCount * sizeof(TextEntry) + header.textBytes;
+    if (size != expected) {
+        return CompactTokenStreamPtr();
+    }
+
+    std::uint32_t const * types = reinterpret_cast<std::uint32_t const *>(static_cast<char const *>(data) + sizeof(header));
+    std::uint32_t const * channels = types + n;
+    std::uint32_t const * starts = channels + n;
+    std::uint32_t const * stops = starts + n;
+    TextEntry const * entries = reinterpret_cast<TextEntry const *>(stops + n);
+    char const * text = reinterpret_cast<char const *>(entries + header.textCount);
+
+    if (types[n - 1] != TokenEof) {
+        return CompactTokenStreamPtr();
+    }
+
+    // Offsets are used to slice the input without further checks
+    //
+    for (std::size_t i = 0; i < n; ++i) {
+        if (starts[i] > stops[i] || stops[i] > inputSize) {
+            return CompactTokenStreamPtr();
+        }
+    }
+
+    CompactTokenStreamPtr stream = makeShared<CompactTokenStream>(TokenSourcePtr());
+    stream->assign(n, types, channels, starts, stops, std::move(input));
+    for (std::uint32_t i = 0; i < header.textCount; ++i) {
+        TextEntry const & entry = entries[i];
+        if (entry.index >= n || entry.offset > header.textBytes || entry.size > header.textBytes - entry.offset) {
+            return CompactTokenStreamPtr();
+        }
+        stream->setText(entry.index, fromUTF8(std::string(text + entry.offset, entry.size)));
+    }
+    return stream;
+}
+
+CompactTokenStreamPtr TokenCache::load(char const * fileName, std::uint64_t inputHash,
+                                       LocationSourcePtr input, Index inputSize)
+{
+    ByteCharStream::DataRef data = ByteCharStream::mapFile(fileName);
+    if (!data) {
+        return CompactTokenStreamPtr();
+    }
+    return load(data.begin(), data.size(), inputHash, std::move(input), inputSize);
+}
+
+} // namespace antlr3
@@ -0,0 +1,90 @@
+/** \file
+ * Defines a binary cache of lexed tokens, so that unchanged input
+ * does not have to be lexed again.
+ */
+#ifndef _ANTLR3_TOKENCACHE_HPP
+#define _ANTLR3_TOKENCACHE_HPP
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/TokenStream.hpp>
+#include <antlr3/CompactTokenStream.hpp>
+#include <ostream>
+
+namespace antlr3 {
+
+/** Reads and writes tokens of a stream in a compact binary format.
+ *
+ *  The cache stores type, channel, start and stop offsets of every token
+ *  as four arrays of 32-bit values, followed by a table of overridden
+ *  token text in UTF-8. The header carries a format version and a hash
+ *  of the input the tokens were produced from; a cache whose version or
+ *  hash does not match is ignored. Values are stored in native byte order,
+ *  so a cache written on a machine of different endianness is ignored too.
+ *
+ *  Loading maps the file into memory and copies the arrays in bulk into
+ *  a CompactTokenStream, without creating a token object per token
+ *  and without running the lexer.
+ */
+class TokenCache
+{
+public:
+    /// Version of the format, increased on every incompatible change.
+    static std::uint32_t const Version = 1;
+
+    /// Hash of the input to key the cache with. Uses 64-bit FNV-1a.
+    static std::uint64_t hash(void const * data, std::size_t size);
+
+    /** Writes all tokens of \a stream. All tokens must come from the same input.
+     *  Returns false if writing failed, or if the stream has released consumed
+     *  tokens and so does not have all of them.
+     */
+    static bool write(std::ostream & out, CommonTokenStream & stream, std::uint64_t inputHash);
+    static bool write(char const * fileName, CommonTokenStream & stream, std::uint64_t inputHash);
+
+    /** Creates a stream over \a input with tokens read from the cache in memory.
+     *  \a data must be aligned to 4 bytes. \a inputSize is the size of \a input
+     *  in the units of its indices, such as BasicCharStream::size().
+     *  Returns null if the data is not a valid cache for input with hash \a inputHash,
+     *  or if a token does not fit in the input.
+     */
+    static CompactTokenStreamPtr load(void const * data, std::size_t size, std::uint64_t inputHash,
+                                      LocationSourcePtr input, Index inputSize);
+
+    /** Same as above, with the cache read from a memory-mapped file.
+     *  Returns null if the file does not exist as well.
+     */
+    static CompactTokenStreamPtr load(char const * fileName, std::uint64_t inputHash,
+                                      LocationSourcePtr input, Index inputSize);
+};
+
+} // namespace antlr3
+
+#endif
@@ -0,0 +1,129 @@
+/** \file
+ * Implementation of the token factories.
+ */
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/TokenFactory.hpp>
+
+namespace antlr3 {
+
+CommonTokenPtr TokenFactory::newToken()
+{
+    return makeShared<CommonToken>();
+}
+
+PooledTokenFactory::PooledTokenFactory(std::size_t slabSize)
+    : TokenFactory()
+    , slabSize_(slabSize)
+    , slabs_()
+    , slab_(0)
+    , next_(0)
+{
+    assert(slabSize_ > 0);
+}
+
+PooledTokenFactory::~PooledTokenFactory()
+{
+}
+
+CommonTokenPtr PooledTokenFactory::newToken()
+{
+    if (next_ == slabSize_)
+    {
+        // Current slab is used up, move on to the next one
+        //
+        slab_++;
+        next_ = 0;
+    }
+
+    if (slab_ == slabs_.size())
+    {
+        slabs_.push_back(makeShared<std::vector<CommonToken>>(slabSize_));
+    }
+    else if (!slabs_[slab_])
+    {
+        slabs_[slab_] = makeShared<std::vector<CommonToken>>(slabSize_);
+    }
+
+    SlabPtr const & slab = slabs_[slab_];
+    CommonToken * token = &(*slab)[next_++];
+
+    // Token may have been used before the reset
+    //
+    *token = CommonToken();
+
+    // Token shares ownership of the slab
+    //
+    return CommonTokenPtr(slab, token);
+}
+
+void PooledTokenFactory::reset()
+{
+    // Only the slabs that were handed out from can be referenced
+    //
+    std::size_t used = std::min(slab_ + 1, slabs_.size());
+    for (std::size_t i = 0; i < used; i++)
+    {
+        if (!slabs_[i])
+        {
+            continue;
+        }
+
+        if (slabs_[i].use_count() > 1)
+        {
+            // Somebody still holds tokens from this slab, it will be
+            // replaced when needed
+            //
+            slabs_[i].reset();
+            continue;
+        }
+
+        // Recycled tokens must not keep their input streams and text alive
+        // until they are handed out again
+        //
+        std::size_t count = i < slab_ ? slabSize_ : next_;
+        std::vector<CommonToken> & slab = *slabs_[i];
+        for (std::size_t j = 0; j < count; j++)
+        {
+            slab[j] = CommonToken();
+        }
+    }
+
+    slab_ = 0;
+    next_ = 0;
+}
+
+std::size_t PooledTokenFactory::size() const
+{
+    return slab_ * slabSize_ + next_;
+}
+
+} // namespace antlr3
@@ -0,0 +1,96 @@
+/** \file
+ * Defines token factories used by the lexer to create tokens, including
+ * a pooled factory that recycles token memory between parses.
+ */
+#ifndef _ANTLR3_TOKENFACTORY_HPP
+#define _ANTLR3_TOKENFACTORY_HPP
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/Defs.hpp>
+#include <antlr3/CommonToken.hpp>
+#include <vector>
+
+namespace antlr3 {
+
+/// Creates tokens for the lexer.
+/// Default implementation allocates every token separately.
+class TokenFactory
+{
+public:
+    virtual ~TokenFactory() {}
+
+    /// Returns a new token with default field values.
+    virtual CommonTokenPtr newToken();
+};
+
+/// Token factory that allocates tokens in slabs, the same way the C runtime
+/// token factory does.
+///
+/// Tokens share the reference count of their slab, so handing out a token does not
+/// allocate. A slab is kept alive while any of its tokens is referenced,
+/// even after the factory is destroyed.
+///
+/// reset() makes the memory of all slabs available for reuse without returning
+/// it to the system. Slabs that still have tokens referenced from outside are
+/// left to their owners and replaced with new ones, so reset() never
+/// invalidates live tokens.
+class PooledTokenFactory : public TokenFactory
+{
+public:
+    PooledTokenFactory(std::size_t slabSize = 1024);
+    virtual ~PooledTokenFactory();
+
+    virtual CommonTokenPtr newToken() override;
+
+    /// Recycles all tokens handed out so far.
+    void reset();
+
+    /// Number of tokens handed out since the last reset.
+    std::size_t size() const;
+private:
+    typedef SharedPtr<std::vector<CommonToken>> SlabPtr;
+
+    /// Number of tokens in each slab.
+    std::size_t slabSize_;
+
+    /// Allocated slabs, slabs before current one are used up.
+    std::vector<SlabPtr> slabs_;
+
+    /// Index of the slab that next token comes from.
+    std::size_t slab_;
+
+    /// Index of the next token in current slab.
+    std::size_t next_;
+};
+
+} // namespace antlr3
+
+#endif
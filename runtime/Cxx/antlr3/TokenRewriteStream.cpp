@@ -0,0 +1,351 @@
+/** \file
+ * Implementation of the token stream that renders rewritten text.
+ */
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/TokenRewriteStream.hpp>
+#include <algorithm>
+#include <sstream>
+
+namespace antlr3 {
+
+ConstString const TokenRewriteStream::DefaultProgramName = ANTLR3_T("default");
+
+TokenRewriteStream::TokenRewriteStream(TokenSourcePtr source)
+    : CommonTokenStream(source)
+    , programs_()
+{
+}
+
+TokenRewriteStream::~TokenRewriteStream()
+{
+}
+
+void TokenRewriteStream::rollback(Index instructionIndex, String const & programName)
+{
+    auto it = programs_.find(programName);
+    if (it != programs_.end() && instructionIndex < it->second.operations.size())
+    {
+        it->second.operations.resize(instructionIndex);
+    }
+}
+
+void TokenRewriteStream::deleteProgram(String const & programName)
+{
+    rollback(0, programName);
+}
+
+Index TokenRewriteStream::instructionCount(String const & programName) const
+{
+    auto it = programs_.find(programName);
+    return it != programs_.end() ? it->second.operations.size() : 0;
+}
+
+void TokenRewriteStream::insertBefore(Index index, String text, String const & programName)
+{
+    addOperation(programName, Operation::InsertBefore, index, index, std::move(text), false);
+}
+
+void TokenRewriteStream::insertBefore(CommonTokenPtr t, String text, String const & programName)
+{
+    insertBefore(t->tokenIndex(), std::move(text), programName);
+}
+
+void TokenRewriteStream::insertAfter(Index index, String text, String const & programName)
+{
+    // Inserting after a token is inserting before the next one
+    //
+    insertBefore(index + 1, std::move(text), programName);
+}
+
+void TokenRewriteStream::insertAfter(CommonTokenPtr t, String text, String const & programName)
+{
+    insertAfter(t->tokenIndex(), std::move(text), programName);
+}
+
+void TokenRewriteStream::replace(Index from, Index to, String text, String const & programName)
+{
+    addOperation(programName, Operation::Replace, from, to, std::move(text), false);
+}
+
+void TokenRewriteStream::replace(Index index, String text, String const & programName)
+{
+    replace(index, index, std::move(text), programName);
+}
+
+void TokenRewriteStream::replace(CommonTokenPtr from, CommonTokenPtr to, String text, String const & programName)
+{
+    replace(from->tokenIndex(), to->tokenIndex(), std::move(text), programName);
+}
+
+void TokenRewriteStream::remove(Index from, Index to, String const & programName)
+{
+    addOperation(programName, Operation::Replace, from, to, String(), true);
+}
+
+void TokenRewriteStream::remove(Index index, String const & programName)
+{
+    remove(index, index, programName);
+}
+
+void TokenRewriteStream::remove(CommonTokenPtr from, CommonTokenPtr to, String const & programName)
+{
+    remove(from->tokenIndex(), to->tokenIndex(), programName);
+}
+
+Index TokenRewriteStream::lastRewriteTokenIndex(String const & programName) const
+{
+    auto it = programs_.find(programName);
+    return it != programs_.end() ? it->second.lastRewriteTokenIndex : NullIndex;
+}
+
+String TokenRewriteStream::toString()
+{
+    return toString(DefaultProgramName, 0, NullIndex);
+}
+
+String TokenRewriteStream::toString(std::uint32_t start, std::uint32_t stop)
+{
+    return toString(DefaultProgramName, start, stop);
+}
+
+String TokenRewriteStream::toString(String const & programName, Index start, Index stop)
+{
+    std::basic_ostringstream<String::value_type> out;
+    render(out, programName, start, stop);
+    return out.str();
+}
+
+String TokenRewriteStream::toOriginalString()
+{
+    return CommonTokenStream::toString(0, (std::uint32_t)size());
+}
+
+String TokenRewriteStream::toOriginalString(Index start, Index stop)
+{
+    return CommonTokenStream::toString((std::uint32_t)start, (std::uint32_t)stop);
+}
+
+void TokenRewriteStream::render(std::basic_ostream<String::value_type> & out, String const & programName, Index start, Index stop)
+{
+    Index n = size();
+    Index end = std::min(stop, n);
+    if (start >= end)
+    {
+        return;
+    }
+
+    std::vector<Operation> operations;
+    auto programI = programs_.find(programName);
+    if (programI != programs_.end())
+    {
+        operations = reduce(programI->second.operations);
+        programI->second.lastRewriteTokenIndex = end - 1;
+    }
+
+    // Walk the operations in token order, copying the tokens in between as they are
+    //
+    auto op = std::lower_bound(operations.begin(), operations.end(), start,
+        [](Operation const & o, Index i) { return o.index < i; });
+    Index i = start;
+    for (; op != operations.end() && op->index < end; ++op)
+    {
+        writeTokens(out, i, op->index);
+        out.write(op->text.data(), op->text.size());
+        i = op->kind == Operation::Replace ? op->lastIndex + 1 : op->index;
+    }
+    writeTokens(out, i, end);
+
+    // Inserts at the very end of the input go after all of the tokens
+    //
+    if (end + 1 >= n)
+    {
+        for (; op != operations.end(); ++op)
+        {
+            if (op->index + 1 >= n)
+            {
+                out.write(op->text.data(), op->text.size());
+            }
+        }
+    }
+}
+
+void TokenRewriteStream::addOperation(String const & programName, Operation::Kind kind, Index from, Index to, String text, bool isDelete)
+{
+    assert(from <= to);
+
+    std::vector<Operation> & operations = programs_[programName].operations;
+    Operation op;
+    op.kind = kind;
+    op.instructionIndex = operations.size();
+    op.index = from;
+    op.lastIndex = to;
+    op.text = std::move(text);
+    op.isDelete = isDelete;
+    operations.push_back(std::move(op));
+}
+
+/** Applies the instructions in order, keeping live inserts and replaces in maps
+ *  by token index. Live replaces never overlap, so every instruction only has to
+ *  look at its neighbours, and every operation is dropped at most once.
+ */
+std::vector<TokenRewriteStream::Operation> TokenRewriteStream::reduce(std::vector<Operation> const & operations)
+{
+    std::vector<Operation> ops = operations;
+    std::vector<bool> alive(ops.size(), true);
+    std::map<Index, Index> inserts;
+    std::map<Index, Index> replaces;
+
+    for (Index k = 0; k < ops.size(); ++k)
+    {
+        Operation & op = ops[k];
+        if (op.kind == Operation::Replace)
+        {
+            // Inserts before the replaced range become part of its text,
+            // inserts inside of it are dropped
+            //
+            auto insertI = inserts.lower_bound(op.index);
+            while (insertI != inserts.end() && insertI->first <= op.lastIndex)
+            {
+                if (insertI->first == op.index)
+                {
+                    op.text = ops[insertI->second].text + op.text;
+                    op.isDelete = false;
+                }
+                alive[insertI->second] = false;
+                insertI = inserts.erase(insertI);
+            }
+
+            // Previous replaces that overlap this one are either covered by it,
+            // or are deletes merged with it
+            //
+            Index first = op.index;
+            Index last = op.lastIndex;
+            auto replaceI = replaces.upper_bound(last);
+            while (replaceI != replaces.begin())
+            {
+                --replaceI;
+                Operation & prev = ops[replaceI->second];
+                if (prev.lastIndex < first)
+                {
+                    break;
+                }
+
+                if (prev.index < first || prev.lastIndex > last)
+                {
+                    assert(prev.isDelete && op.isDelete && "replace overlaps a previous replace");
+                    op.index = std::min(op.index, prev.index);
+                    op.lastIndex = std::max(op.lastIndex, prev.lastIndex);
+                }
+                alive[replaceI->second] = false;
+                replaceI = replaces.erase(replaceI);
+            }
+            replaces[op.index] = k;
+        }
+        else
+        {
+            // Inserts at the same index are combined, the latest goes first
+            //
+            auto insertI = inserts.find(op.index);
+            if (insertI != inserts.end())
+            {
+                op.text += ops[insertI->second].text;
+                alive[insertI->second] = false;
+                inserts.erase(insertI);
+            }
+
+            // An insert before a replaced range becomes part of its text
+            //
+            auto replaceI = replaces.upper_bound(op.index);
+            if (replaceI != replaces.begin())
+            {
+                --replaceI;
+                Operation & rop = ops[replaceI->second];
+                if (rop.index == op.index)
+                {
+                    rop.text = op.text + rop.text;
+                    rop.isDelete = false;
+                    alive[k] = false;
+                    continue;
+                }
+                if (op.index <= rop.lastIndex)
+                {
+                    assert(false && "insert within boundaries of a previous replace");
+                    alive[k] = false;
+                    continue;
+                }
+            }
+            inserts[op.index] = k;
+        }
+    }
+
+    std::vector<Operation> result;
+    for (Index k = 0; k < ops.size(); ++k)
+    {
+        if (alive[k])
+        {
+            result.push_back(std::move(ops[k]));
+        }
+    }
+    std::sort(result.begin(), result.end(), [](Operation const & a, Operation const & b) {
+        return a.index < b.index;
+    });
+    return result;
+}
+
+void TokenRewriteStream::writeTokens(std::basic_ostream<String::value_type> & out, Index start, Index stop)
+{
+    if (start >= stop)
+    {
+        return;
+    }
+
+    // Untouched tokens are usually a single slice of the input
+    //
+    StringView span = spanText((std::uint32_t)start, (std::uint32_t)stop);
+    if (!span.isNull())
+    {
+        out.write(span.data(), span.size());
+        return;
+    }
+
+    for (Index i = start; i < stop; ++i)
+    {
+        CommonTokenPtr t = get(i);
+        if (t->type() != TokenEof)
+        {
+            String text = t->text();
+            out.write(text.data(), text.size());
+        }
+    }
+}
+
+} // namespace antlr3
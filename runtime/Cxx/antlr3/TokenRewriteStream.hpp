@@ -0,0 +1,172 @@
+/** \file
+ * Defines a token stream that records text edits on top of the tokens
+ * and renders the edited text on request, leaving the tokens untouched.
+ */
+#ifndef _ANTLR3_TOKENREWRITESTREAM_HPP
+#define _ANTLR3_TOKENREWRITESTREAM_HPP
+
+// [The "BSD licence"]
+// Copyright (c) 2005-2009 Jim Idle, Temporal Wave LLC
+// http://www.temporal-wave.com
+// http://www.linkedin.com/in/jimidle
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. The name of the author may not be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+// NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <antlr3/TokenStream.hpp>
+#include <map>
+#include <ostream>
+#include <vector>
+
+namespace antlr3 {
+
+/** Token stream for source-to-source translation.
+ *
+ *  Edits such as insertBefore(), replace() and remove() are recorded as
+ *  instructions of a named rewrite program and are only applied when the
+ *  text is rendered, so tokens are never copied or shifted. Several programs
+ *  can be kept over the same tokens, for example to produce different
+ *  views of one input; rollback() undoes instructions of a program.
+ *
+ *  When rendering, instructions are reduced to at most one operation per
+ *  token: inserts before a replaced range are folded into it, inserts inside
+ *  a replaced range and replaces covered by a later replace are dropped,
+ *  and overlapping deletes are merged. Any other overlap of replaces is an error.
+ *  Text between operations is written as slices of the input where possible,
+ *  so rendering is a single pass over the tokens.
+ *
+ *  toString() returns the rewritten text of the default program,
+ *  toOriginalString() returns the text as it was in the input.
+ *  All tokens are read on the first rendering; releasing consumed tokens
+ *  is not supported.
+ */
+class TokenRewriteStream : public CommonTokenStream
+{
+public:
+    static ConstString const DefaultProgramName;
+
+    TokenRewriteStream(TokenSourcePtr source);
+    ~TokenRewriteStream();
+
+    /** Discards instructions of the program starting from \a instructionIndex.
+     *  Instruction indices are returned by instructionCount().
+     */
+    void rollback(Index instructionIndex, String const & programName = DefaultProgramName);
+
+    /** Discards all instructions of the program.
+     */
+    void deleteProgram(String const & programName = DefaultProgramName);
+
+    /** Number of instructions recorded in the program so far.
+     */
+    Index instructionCount(String const & programName = DefaultProgramName) const;
+
+    void insertBefore(Index index, String text, String const & programName = DefaultProgramName);
+    void insertBefore(CommonTokenPtr t, String text, String const & programName = DefaultProgramName);
+    void insertAfter(Index index, String text, String const & programName = DefaultProgramName);
+    void insertAfter(CommonTokenPtr t, String text, String const & programName = DefaultProgramName);
+
+    /** Replaces tokens from \a from to \a to inclusive with \a text.
+     */
+    void replace(Index from, Index to, String text, String const & programName = DefaultProgramName);
+    void replace(Index index, String text, String const & programName = DefaultProgramName);
+    void replace(CommonTokenPtr from, CommonTokenPtr to, String text, String const & programName = DefaultProgramName);
+
+    /** Removes tokens from \a from to \a to inclusive.
+     */
+    void remove(Index from, Index to, String const & programName = DefaultProgramName);
+    void remove(Index index, String const & programName = DefaultProgramName);
+    void remove(CommonTokenPtr from, CommonTokenPtr to, String const & programName = DefaultProgramName);
+
+    /** Index of the last token that the program was rendered up to, NullIndex if never rendered.
+     */
+    Index lastRewriteTokenIndex(String const & programName = DefaultProgramName) const;
+
+    virtual String toString() override;
+    virtual String toString(std::uint32_t start, std::uint32_t stop) override;
+    using CommonTokenStream::toString;
+
+    /** Returns rewritten text of tokens from \a start up to, but not including, \a stop.
+     */
+    String toString(String const & programName, Index start, Index stop);
+
+    String toOriginalString();
+    String toOriginalString(Index start, Index stop);
+
+    /** Writes rewritten text of tokens from \a start up to, but not including, \a stop
+     *  to \a out. Rewriting the whole input writes inserts at its end as well.
+     */
+    void render(std::basic_ostream<String::value_type> & out,
+                String const & programName = DefaultProgramName,
+                Index start = 0, Index stop = NullIndex);
+private:
+    /** Single recorded edit. Insert after is an insert before the next token,
+     *  delete is a replace without text.
+     */
+    struct Operation
+    {
+        enum Kind { InsertBefore, Replace };
+
+        Kind kind;
+
+        /// Position of the operation in the program.
+        Index instructionIndex;
+
+        /// First token affected.
+        Index index;
+
+        /// Last token replaced, same as index for inserts.
+        Index lastIndex;
+
+        String text;
+
+        /// True for a replace that only deletes tokens.
+        bool isDelete;
+    };
+
+    struct Program
+    {
+        std::vector<Operation> operations;
+        Index lastRewriteTokenIndex;
+
+        Program() : operations(), lastRewriteTokenIndex(NullIndex) {}
+    };
+
+    std::map<String, Program> programs_;
+
+    void addOperation(String const & programName, Operation::Kind kind, Index from, Index to, String text, bool isDelete);
+
+    /** Reduces operations of the program to at most one per token,
+     *  returned in order of token index.
+     */
+    static std::vector<Operation> reduce(std::vector<Operation> const & operations);
+
+    /** Writes text of tokens from \a start up to, but not including, \a stop as they are.
+     */
+    void writeTokens(std::basic_ostream<String::value_type> & out, Index start, Index stop);
+};
+
+} // namespace antlr3
+
+#endif
@@ -39,11 +39,23 @@ CommonTokenStream::CommonTokenStream(TokenSourcePtr source)
     : TokenStream()
     , tokenSource_(source)
     , tokens_()
+    , types_()
+    , ordinals_()
+    , onChannel_()
+    , base_(0)
+    , onBase_(0)
+    , eof_(false)
+    , lazy_(false)
+    , releaseConsumed_(false)
+    , pinned_()
+    , indexTypes_(false)
+    , postings_()
     , channelOverrides_()
-    , discardSet_()
+    , discardTypes_()
     , channel_(TokenDefaultChannel)
     , discardOffChannel_(false)
     , p_(NullIndex)
+    , cp_(0)
 {
 }
 
@@ -70,30 +82,58 @@ String CommonTokenStream::sourceName()
  */
 void CommonTokenStream::consume()
 {
-    if(p_ < tokens_.size())
+    fillBufferIfNeeded();
+    if(fetch(p_ + 1))
     {
-        p_++;
-        p_ = skipOffTokenChannels(p_);
+        // Step over the current token if it is on channel, the next
+        // on-channel token is then the new current one
+        //
+        if(onChannelAt(cp_) == p_)
+        {
+            cp_++;
+        }
+        p_ = onChannelAt(cp_);
+
+        if(releaseConsumed_)
+        {
+            release();
+        }
     }
 }
 
 std::uint32_t CommonTokenStream::LA(std::int32_t i)
 {
-    CommonTokenPtr tok = LT(i);
-
-    if(tok != NULL)
+    Index n = lookIndex(i);
+    if(n == NullIndex)
     {
-        return tok->type();
+        return TokenInvalid;
     }
-    else
+    if(n >= bufferEnd())
     {
-        return TokenInvalid;
+        return TokenEof;
     }
+    return types_[n - base_];
 }
 
 MarkerPtr CommonTokenStream::mark()
 {
-    return std::make_shared<TokenStreamMarker>(index(), shared_from_this());
+    return makeShared<TokenStreamMarker>(index(), shared_from_this());
+}
+
+Checkpoint CommonTokenStream::checkpoint()
+{
+    // Released streams need a marker to keep tokens from being discarded
+    //
+    if(releaseConsumed_)
+    {
+        return Checkpoint(index(), mark());
+    }
+    return Checkpoint(index());
+}
+
+void CommonTokenStream::restore(Checkpoint const & cp)
+{
+    seek(cp.index());
 }
 
 Index CommonTokenStream::index()
@@ -104,55 +144,33 @@ Index CommonTokenStream::index()
 
 void CommonTokenStream::seek(Index index)
 {
+    // Tokens before the buffer were released and cannot be returned to
+    //
+    assert(index >= base_);
     p_ = index;
+    cp_ = ordinalAt(index);
 }
 
 
 CommonTokenPtr CommonTokenStream::LT(std::int32_t k)
 {
-    if(k <= 0)
-    {
-        return LB(-k);
-    }
-
-    fillBufferIfNeeded();
-
-    // Here we used to check for k == 0 and return 0, but this seems
-    // a superfluous check to me. LT(k=0) is therefore just undefined
-    // and we won't waste the clock cycles on the check
-    //
-
-    if((p_ + k - 1) >= tokens_.size())
+    Index n = lookIndex(k);
+    if(n == NullIndex)
     {
-        return eofToken();
-    }
-
-    Index i = p_;
-    std::int32_t n = 1;
-
-    /* Need to find k good tokens, skipping ones that are off channel
-    */
-    while(n < k)
-    {
-        /* Skip off-channel tokens */
-        i = skipOffTokenChannels(i+1); /* leave p on valid token    */
-        n++;
+        return NULL;
     }
-    if(i >= (std::int32_t)tokens_.size())
+    if(n >= bufferEnd())
     {
         return eofToken();
     }
-
-    // Here the token must be in the input vector. Rather then incur
-    // function call penalty, we just return the pointer directly
-    // from the vector
-    //
-    return tokens_.at(i);
+    return tokens_[n - base_];
 }
 
 CommonTokenPtr CommonTokenStream::get(Index i)
 {
-    return tokens_.at(i);
+    assert(i >= base_);
+    fetch(i + 1);
+    return tokens_.at(i - base_);
 }
 
 TokenSourcePtr CommonTokenStream::tokenSource()
@@ -163,18 +181,32 @@ TokenSourcePtr CommonTokenStream::tokenSource()
 String CommonTokenStream::toString()
 {
     fillBufferIfNeeded();
-    return  toString(0, (std::uint32_t)tokens_.size());
+    fetch(NullIndex);
+    return  toString((std::uint32_t)base_, (std::uint32_t)bufferEnd());
 }
 
 String CommonTokenStream::toString(std::uint32_t start, std::uint32_t stop)
 {
     fillBufferIfNeeded();
+    fetch(stop);
 
-    assert(!tokens_.empty() && tokens_.back()->type() == TokenEof);
-    const std::uint32_t maxIndex = (std::uint32_t)tokens_.size() - 1;
+    assert(!tokens_.empty());
+
+    // Released tokens are gone, so the text starts at the first buffered one
+    //
+    start = std::max(start, (std::uint32_t)base_);
+    const std::uint32_t maxIndex = (std::uint32_t)(eof_ ? bufferEnd() - 1 : bufferEnd());
     start = std::min(start, maxIndex);
     stop = std::min(stop, maxIndex);
 
+    // Contiguous tokens are copied out of the input in one go
+    //
+    StringView span = spanText(start, stop);
+    if(!span.isNull())
+    {
+        return span.str();
+    }
+
     String string;
 
     for(std::uint32_t i = start; i < stop; i++)
@@ -189,6 +221,47 @@ String CommonTokenStream::toString(std::uint32_t start, std::uint32_t stop)
     return string;
 }
 
+StringView CommonTokenStream::spanText(std::uint32_t start, std::uint32_t stop)
+{
+    fillBufferIfNeeded();
+    fetch(stop);
+
+    assert(!tokens_.empty());
+
+    // Released tokens are gone, so the text starts at the first buffered one
+    //
+    start = std::max(start, (std::uint32_t)base_);
+    const std::uint32_t maxIndex = (std::uint32_t)(eof_ ? bufferEnd() - 1 : bufferEnd());
+    start = std::min(start, maxIndex);
+    stop = std::min(stop, maxIndex);
+
+    if(start >= stop)
+    {
+        return StringView(ANTLR3_T(""), 0);
+    }
+
+    // Views of adjacent tokens must follow each other in the same buffer
+    //
+    StringView first = tokens_[start - base_]->textView();
+    if(first.isNull())
+    {
+        return StringView();
+    }
+
+    StringView::const_iterator end = first.end();
+    for(std::uint32_t i = start + 1; i < stop; i++)
+    {
+        StringView view = tokens_[i - base_]->textView();
+        if(view.isNull() || view.begin() != end)
+        {
+            return StringView();
+        }
+        end = view.end();
+    }
+
+    return StringView(first.begin(), end - first.begin());
+}
+
 String CommonTokenStream::toString(CommonTokenPtr start, CommonTokenPtr stop)
 {
     if(start != NULL && stop != NULL)
@@ -209,18 +282,27 @@ String CommonTokenStream::toString(CommonTokenPtr start, CommonTokenPtr stop)
  */
 void CommonTokenStream::setTokenTypeChannel(std::uint32_t ttype, std::uint32_t channel)
 {
-    /* We add one to the channel so we can distinguish NULL as being no entry in the
+    assert(ttype != TokenEof);
+
+    /* We add one to the channel so we can distinguish zero as being no entry in the
      * table for a particular token type.
      */
+    if(ttype >= channelOverrides_.size())
+    {
+        channelOverrides_.resize(ttype + 1);
+    }
     channelOverrides_[ttype] = channel + 1;
 }
 
 void CommonTokenStream::discardTokenType(std::uint32_t ttype)
 {
-    /* We add one to the channel so we can distinguish NULL as being no entry in the
-     * table for a particular token type. We could use bitsets for this I suppose too.
-     */
-    discardSet_.insert(ttype);
+    assert(ttype != TokenEof);
+
+    if(ttype >= discardTypes_.size())
+    {
+        discardTypes_.resize(ttype + 1);
+    }
+    discardTypes_[ttype] = true;
 }
 
 void CommonTokenStream::discardOffChannelToks(bool discard)
@@ -228,10 +310,63 @@ void CommonTokenStream::discardOffChannelToks(bool discard)
     discardOffChannel_ = discard;
 }
 
+void CommonTokenStream::setLazy(bool lazy)
+{
+    assert(p_ == NullIndex);
+    lazy_ = lazy;
+}
+
+void CommonTokenStream::setReleaseConsumed(bool release)
+{
+    assert(p_ == NullIndex);
+    releaseConsumed_ = release;
+    lazy_ = lazy_ || release;
+}
+
 std::vector<CommonTokenPtr> CommonTokenStream::tokens()
 {
     fillBufferIfNeeded();
-    return tokens_;
+    fetch(NullIndex);
+    return std::vector<CommonTokenPtr>(tokens_.begin(), tokens_.end());
+}
+
+Span<CommonTokenPtr> CommonTokenStream::bufferedTokens()
+{
+    fillBufferIfNeeded();
+    if (!releaseConsumed_) {
+        fetch(NullIndex);
+    }
+    return Span<CommonTokenPtr>(tokens_.data(), tokens_.data() + tokens_.size());
+}
+
+void CommonTokenStream::setIndexTokenTypes(bool index)
+{
+    assert(p_ == NullIndex);
+    indexTypes_ = index;
+}
+
+Span<std::uint32_t> CommonTokenStream::tokenIndicesOfType(std::uint32_t type, std::uint32_t start, std::uint32_t stop)
+{
+    assert(indexTypes_);
+    fillBufferIfNeeded();
+    fetch(Index(stop) + 1);
+
+    if (type >= postings_.size() || start > stop)
+    {
+        return Span<std::uint32_t>();
+    }
+
+    std::vector<std::uint32_t> const & postings = postings_[type];
+    auto first = std::lower_bound(postings.begin(), postings.end(), std::max<Index>(start, base_));
+    auto last = std::upper_bound(first, postings.end(), stop);
+    return Span<std::uint32_t>(postings.data() + (first - postings.begin()), postings.data() + (last - postings.begin()));
+}
+
+Index CommonTokenStream::size()
+{
+    fillBufferIfNeeded();
+    fetch(NullIndex);
+    return bufferEnd();
 }
 
 std::vector<CommonTokenPtr> CommonTokenStream::getTokenRange(std::uint32_t start, std::uint32_t stop)
@@ -246,8 +381,9 @@ std::vector<CommonTokenPtr> CommonTokenStream::getTokenRange(std::uint32_t start
 std::vector<CommonTokenPtr> CommonTokenStream::getTokensSet(std::uint32_t start, std::uint32_t stop, Bitset const & types)
 {
     fillBufferIfNeeded();
+    fetch(Index(stop) + 1);
 
-    stop = std::min(stop, (std::uint32_t)tokens_.size() - 1);
+    stop = std::min(stop, (std::uint32_t)bufferEnd() - 1);
 
     /* We have the range set, now we need to iterate through the
      * installed tokens and create a new list with just the ones we want
@@ -255,6 +391,30 @@ std::vector<CommonTokenPtr> CommonTokenStream::getTokensSet(std::uint32_t start,
      */
     std::vector<CommonTokenPtr> filteredList;
 
+    // With the type index only the matching tokens are visited
+    //
+    if(indexTypes_)
+    {
+        std::vector<std::uint32_t> indices;
+        std::uint32_t maxType = (std::uint32_t)std::min<std::size_t>(types.capacity(), postings_.size());
+        for(std::uint32_t type = 0; type < maxType; type++)
+        {
+            if(types.isMember(type))
+            {
+                Span<std::uint32_t> span = tokenIndicesOfType(type, start, stop);
+                indices.insert(indices.end(), span.begin(), span.end());
+            }
+        }
+        std::sort(indices.begin(), indices.end());
+
+        filteredList.reserve(indices.size());
+        for(std::uint32_t i : indices)
+        {
+            filteredList.push_back(tokens_[i - base_]);
+        }
+        return filteredList;
+    }
+
     for(std::uint32_t i = start; i<= stop; i++)
     {
         CommonTokenPtr tok = get(i);
@@ -286,7 +446,7 @@ void CommonTokenStream::reset()
     // Free any resources that ar most like specifc to the
     // run we just did.
     //
-    discardSet_.clear();
+    discardTypes_.clear();
     channelOverrides_.clear();
 
     // Now, if there were any existing tokens in the stream,
@@ -297,22 +457,30 @@ void CommonTokenStream::reset()
     // vector entries.
     //
     tokens_.clear();
+    types_.clear();
+    ordinals_.clear();
+    onChannel_.clear();
+    postings_.clear();
+    base_ = 0;
+    onBase_ = 0;
+    eof_ = false;
 
     // Reset to defaults
     //
     discardOffChannel_  = false;
     channel_            = TokenDefaultChannel;
     p_	            = -1;
+    cp_                 = 0;
 }
     
-bool CommonTokenStream::shouldDiscard(CommonTokenPtr token) const
+bool CommonTokenStream::shouldDiscard(std::uint32_t type, std::uint32_t channel) const
 {
-    if(discardSet_.count(token->type()) > 0)
+    if(type < discardTypes_.size() && discardTypes_[type])
     {
         return true;
     }
     
-    if(discardOffChannel_ && token->channel() != channel_)
+    if(discardOffChannel_ && channel != channel_)
     {
         return true;
     }
@@ -325,120 +493,157 @@ void CommonTokenStream::fillBufferIfNeeded()
     if (p_ != NullIndex) {
         return;
     }
-    
-    // Start at index 0 of course
-    std::uint32_t index = 0;
 
-    while(true)
+    // Unless filling lazily, read everything up front
+    //
+    if (!lazy_) {
+        fetch(NullIndex);
+    }
+
+    // Set the consume pointer to the first token that is on our channel
+    cp_ = 0;
+    p_ = onChannelAt(cp_);
+}
+
+bool CommonTokenStream::fetch(Index n)
+{
+    while (bufferEnd() < n)
     {
+        if (eof_) {
+            return false;
+        }
+
         CommonTokenPtr tok = tokenSource_->nextToken();
-        if (!shouldDiscard(tok)) {
-            // See if this type is in the override map
-            auto channelI = channelOverrides_.find(tok->type() + 1);
-            if(channelI != channelOverrides_.end())
-            {
-                // Override found
-                tok->setChannel(channelI->second - 1);
-            }
+        std::uint32_t type = tok->type();
+        if (type == TokenEof) {
+            eof_ = true;
+        }
+
+        // See if this type is in the override table
+        //
+        if (type < channelOverrides_.size() && channelOverrides_[type] != 0)
+        {
+            tok->setChannel(channelOverrides_[type] - 1);
+        }
 
+        if (!shouldDiscard(type, tok->channel())) {
             // If not discarding it, add it to the list at the current index
+            Index index = bufferEnd();
             tok->setTokenIndex(index);
-            p_++;
-            tokens_.push_back(tok);
-            index++;
-        }
 
-        if (tok->type() == TokenEof) {
-            break;
+            // Token is numbered with the ordinal of the first on-channel token at or after it
+            //
+            ordinals_.push_back((std::uint32_t)(onBase_ + onChannel_.size()));
+            if (tok->channel() == channel_) {
+                onChannel_.push_back((std::uint32_t)index);
+            }
+            if (indexTypes_ && type != TokenEof) {
+                if (type >= postings_.size()) {
+                    postings_.resize(type + 1);
+                }
+                postings_[type].push_back((std::uint32_t)index);
+            }
+            types_.push_back(type);
+            tokens_.push_back(std::move(tok));
         }
     }
-
-    // Set the consume pointer to the first token that is on our channel
-    p_ = 0;
-    p_ = skipOffTokenChannels(p_);
+    return true;
 }
 
-CommonTokenPtr CommonTokenStream::LB(std::uint32_t k)
+Index CommonTokenStream::onChannelAt(Index ord)
 {
-    fillBufferIfNeeded();
-    
-    if(k == 0)
+    while (onBase_ + onChannel_.size() <= ord)
     {
-        return NULL;
+        if (!fetch(bufferEnd() + 1)) {
+            return bufferEnd();
+        }
     }
-    
-    if(p_ < k)
-    {
-        return NULL;
+    return onChannel_[ord - onBase_];
+}
+
+Index CommonTokenStream::ordinalAt(Index i)
+{
+    if (!fetch(i + 1)) {
+        return onBase_ + onChannel_.size();
     }
+    return ordinals_[i - base_];
+}
 
-    Index i = p_;
-    std::int32_t n = 1;
+Index CommonTokenStream::lookIndex(std::int32_t k)
+{
+    fillBufferIfNeeded();
 
-    /* Need to find k good tokens, going backwards, skipping ones that are off channel
-     */
-    while(n <= (std::int32_t) k)
+    if (k > 0)
     {
-        /* Skip off-channel tokens
-         */
-
-        i = skipOffTokenChannelsReverse(i - 1); /* leave p on valid token    */
-        n++;
+        return onChannelAt(cp_ + k - 1);
     }
-    if(i == NullIndex)
+
+    // On-channel tokens before the current position have ordinals below cp_
+    //
+    Index back = Index(-k);
+    if (back == 0 || cp_ < onBase_ + back)
     {
-        return NULL;
+        return NullIndex;
     }
-    // Here the token must be in the input vector. Rather then incut
-    // function call penalty, we jsut return the pointer directly
-    // from the vector
-    //
-    return tokens_.at(i);
+    return onChannel_[cp_ - back - onBase_];
 }
 
-/// Given a starting index, return the index of the first on-channel
-///  token.
-///
-Index CommonTokenStream::skipOffTokenChannels(Index i)
+void CommonTokenStream::release()
 {
-    Index n = tokens_.size();
+    // Keep the current token, the previous on-channel one for LT(-1),
+    // and everything after the oldest marker
+    //
+    Index keep = std::min(p_, bufferEnd() - 1);
+    Index previous = lookIndex(-1);
+    if (previous != NullIndex) {
+        keep = std::min(keep, previous);
+    }
+    if (!pinned_.empty()) {
+        keep = std::min(keep, pinned_.begin()->first);
+    }
 
-    while(i < n)
-    {
-        CommonTokenPtr tok = tokens_.at(i);
+    // Arrays are compacted once at least half of them can go,
+    // which keeps the cost per consumed token constant
+    //
+    Index released = keep > base_ ? keep - base_ : 0;
+    if (released == 0 || released < tokens_.size() / 2) {
+        return;
+    }
 
-        if(tok->channel() != channel_)
-        {
-            i++;
-        }
-        else
-        {
-            return i;
-        }
+    Index releasedOnChannel = ordinals_[released] - onBase_;
+    tokens_.erase(tokens_.begin(), tokens_.begin() + released);
+    types_.erase(types_.begin(), types_.begin() + released);
+    ordinals_.erase(ordinals_.begin(), ordinals_.begin() + released);
+    onChannel_.erase(onChannel_.begin(), onChannel_.begin() + releasedOnChannel);
+    base_ += released;
+    onBase_ += releasedOnChannel;
+
+    // Type index drops the released tokens as well
+    //
+    for (std::vector<std::uint32_t> & postings : postings_) {
+        auto first = std::lower_bound(postings.begin(), postings.end(), base_);
+        postings.erase(postings.begin(), first);
     }
-    return i;
 }
 
-Index CommonTokenStream::skipOffTokenChannelsReverse(Index x)
+void CommonTokenStream::pin(Index index)
 {
-    while(x != NullIndex)
-    {
-        CommonTokenPtr tok = tokens_.at(x);
-        
-        if(tok->channel() != channel_)
-        {
-            x--;
-        }
-        else
-        {
-            return x;
-        }
+    pinned_[index]++;
+}
+
+void CommonTokenStream::unpin(Index index)
+{
+    auto pinI = pinned_.find(index);
+    assert(pinI != pinned_.end());
+    if (--pinI->second == 0) {
+        pinned_.erase(pinI);
     }
-    return x;
 }
+
     
 CommonTokenPtr CommonTokenStream::eofToken() {
     fillBufferIfNeeded();
+    fetch(NullIndex);
     assert(!tokens_.empty() && tokens_.back()->type() == TokenEof);
     return tokens_.back();
 }
@@ -496,7 +701,7 @@ MarkerPtr DebugTokenStream::mark()
 {
     Index index = input_->index();
     debugger_->mark((int)index);
-    return std::make_shared<DebugTokenStreamMarker>(input_->mark(), (int)index, debugger_);
+    return makeShared<DebugTokenStreamMarker>(input_->mark(), (int)index, debugger_);
 }
 
 Index DebugTokenStream::index()
@@ -542,6 +747,11 @@ String DebugTokenStream::toString(CommonTokenPtr start, CommonTokenPtr stop)
     return input_->toString(start, stop);
 }
 
+StringView DebugTokenStream::spanText(std::uint32_t start, std::uint32_t stop)
+{
+    return input_->spanText(start, stop);
+}
+
 void DebugTokenStream::consumeInitialHiddenTokens()
 {
     if(initialStreamState_)
@@ -40,6 +40,8 @@
 #include <antlr3/CommonToken.hpp>
 #include <antlr3/Bitset.hpp>
 #include <antlr3/DebugEventListener.hpp>
+#include <deque>
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -115,13 +117,20 @@ public:
      *  the pTREENODE_STREAM->toString(Object,Object).
      */
     virtual String toString(CommonTokenPtr start, CommonTokenPtr stop) = 0;
+
+    /** Returns the text of tokens from start to stop as a view into the input
+     *  buffer, without copying. Returns a null view if the tokens do not
+     *  cover a contiguous range of the input, e.g. if some of them have
+     *  overridden text or were discarded; use toString() then.
+     */
+    virtual StringView spanText(std::uint32_t start, std::uint32_t stop) = 0;
 };
 
 /** Common token stream is an implementation of ANTLR_TOKEN_STREAM for the default
  *  parsers and recognizers. You may of course build your own implementation if
  *  you are so inclined.
  */
-class CommonTokenStream : public TokenStream, public std::enable_shared_from_this<CommonTokenStream>
+class CommonTokenStream : public TokenStream, public EnableSharedFromThis<CommonTokenStream>
 {
     class TokenStreamMarker : public Marker
     {
@@ -132,10 +141,20 @@ class CommonTokenStream : public TokenStream, public std::enable_shared_from_thi
             : Marker()
             , p_(p)
             , stream_(stream)
-        {}
+        {
+            if (stream_->releaseConsumed_) {
+                stream_->pin(p_);
+            }
+        }
+
+        ~TokenStreamMarker() {
+            if (stream_->releaseConsumed_) {
+                stream_->unpin(p_);
+            }
+        }
         
         virtual void rewind() {
-            stream_->p_ = p_;
+            stream_->seek(p_);
         }
     };
     
@@ -151,16 +170,49 @@ class CommonTokenStream : public TokenStream, public std::enable_shared_from_thi
      */
     std::vector<CommonTokenPtr> tokens_;
 
-    /** Override map of tokens. If a token type has an entry in here, then
-     *  the pointer in the table points to an int, being the override channel number
-     *  that should always be used for this token type.
+    /// Types of the buffered tokens, so that LA() does not touch the tokens themselves.
+    std::vector<std::uint32_t> types_;
+
+    /// For each buffered token, the ordinal of the first on-channel token at or after it.
+    std::vector<std::uint32_t> ordinals_;
+
+    /// Token indices of the buffered on-channel tokens, indexed by ordinal.
+    std::vector<std::uint32_t> onChannel_;
+
+    /// Index of the first buffered token, non-zero if consumed tokens were released.
+    Index base_;
+
+    /// Ordinal of the first entry in onChannel_.
+    Index onBase_;
+
+    /// True if EOF token was read from the token source.
+    bool eof_;
+
+    /// If true, tokens are read from the source only as far as lookahead requires.
+    bool lazy_;
+
+    /// If true, tokens before the current one and the oldest live marker are released.
+    bool releaseConsumed_;
+
+    /// Numbers of live markers by token index.
+    std::map<Index, std::size_t> pinned_;
+
+    /// If true, postings_ are kept up to date.
+    bool indexTypes_;
+
+    /// Indices of the tokens of each type in increasing order, indexed by token type.
+    std::vector<std::vector<std::uint32_t>> postings_;
+
+    /** Override table of tokens, indexed by token type. A non-zero entry is
+     *  the override channel number plus one that should always be used for
+     *  this token type.
      */
-    std::unordered_map<std::uint32_t, std::uint32_t> channelOverrides_;
+    std::vector<std::uint32_t> channelOverrides_;
 
-    /** Discared set. If a token has an entry in this table, then it is thrown
-     *  away (data pointer is always NULL).
+    /** Discard table, indexed by token type. Tokens of the types marked here
+     *  are thrown away.
      */
-    std::unordered_set<std::uint32_t> discardSet_;
+    std::vector<bool> discardTypes_;
 
     /* The channel number that this token stream is tuned to. For instance, whitespace
      * is usually tuned to channel 99, which no token stream would normally tune to and
@@ -179,11 +231,28 @@ class CommonTokenStream : public TokenStream, public std::enable_shared_from_thi
      */
     Index p_;
 
-    bool shouldDiscard(CommonTokenPtr token) const;
+    /// Ordinal of the first on-channel token at or after p_.
+    Index cp_;
+
+    bool shouldDiscard(std::uint32_t type, std::uint32_t channel) const;
     void fillBufferIfNeeded();
-    CommonTokenPtr LB(std::uint32_t i);
-    Index skipOffTokenChannels(Index i);
-    Index skipOffTokenChannelsReverse(Index i);
+
+    /// Reads tokens until tokens with indices below \a n are buffered.
+    /// Returns false if the source ended before that.
+    bool fetch(Index n);
+    Index bufferEnd() const { return base_ + tokens_.size(); }
+    void release();
+    void pin(Index index);
+    void unpin(Index index);
+
+    /// Token index of the on-channel token with ordinal \a ord, bufferEnd() if there is none.
+    Index onChannelAt(Index ord);
+
+    /// Ordinal of the first on-channel token at or after token index \a i.
+    Index ordinalAt(Index i);
+
+    /// Token index of the k-th on-channel token relative to the current one, NullIndex if before the start.
+    Index lookIndex(std::int32_t k);
     CommonTokenPtr eofToken();
 public:
     CommonTokenStream(TokenSourcePtr source);
@@ -194,8 +263,10 @@ public:
     virtual String sourceName() override;
     virtual void consume() override;
     virtual std::uint32_t LA(std::int32_t i) override;
-    virtual ItemPtr LI(std::int32_t i) override { return LT(i); }
+    virtual Item LI(std::int32_t i) override { return LT(i); }
     virtual MarkerPtr mark() override;
+    virtual Checkpoint checkpoint() override;
+    virtual void restore(Checkpoint const & cp) override;
     virtual Index index() override;
     virtual void seek(Index index) override;
 
@@ -207,13 +278,52 @@ public:
     virtual String toString() override;
     virtual String toString(std::uint32_t start, std::uint32_t stop) override;
     virtual String toString(CommonTokenPtr start, CommonTokenPtr stop) override;
+    virtual StringView spanText(std::uint32_t start, std::uint32_t stop) override;
 
     void setTokenTypeChannel(std::uint32_t ttype, std::uint32_t channel);
     void discardTokenType(std::uint32_t ttype);
     void discardOffChannelToks(bool discard);
 
+    /** By default the whole input is lexed on the first access to the stream.
+     *  In lazy mode tokens are pulled from the token source only as far as
+     *  lookahead requires, so parsing starts right away. Methods that need
+     *  the whole input, such as toString() and tokens(), still read it all.
+     *  Must be set before the stream is used.
+     */
+    void setLazy(bool lazy);
+
+    /** Releases tokens that are behind both the current position and the oldest
+     *  live marker, keeping memory usage bounded for long inputs.
+     *  Released tokens can no longer be accessed with get() or seek(), and
+     *  toString() and spanText() only cover the tokens that are still buffered.
+     *  Implies lazy mode. Must be set before the stream is used.
+     */
+    void setReleaseConsumed(bool release);
+
     std::vector<CommonTokenPtr> tokens();
 
+    /** Returns the buffered tokens without copying them. Reads the whole input,
+     *  unless consumed tokens are released. The span is invalidated when more
+     *  tokens are read or released.
+     */
+    Span<CommonTokenPtr> bufferedTokens();
+
+    /** Keeps indices of the tokens of each type as they are read, so that tokens
+     *  of a type are found with a binary search instead of a scan.
+     *  Must be set before the stream is used.
+     */
+    void setIndexTokenTypes(bool index);
+
+    /** Returns indices of the tokens of type \a type between a start and a stop
+     *  index, inclusive, in increasing order. Requires setIndexTokenTypes().
+     *  The span is invalidated when more tokens are read or released.
+     */
+    Span<std::uint32_t> tokenIndicesOfType(std::uint32_t type, std::uint32_t start, std::uint32_t stop);
+
+    /** Number of tokens in the stream, including EOF. Reads the whole input.
+     */
+    Index size();
+
     /** Function that returns all the tokens between a start and a stop index.
      */
     std::vector<CommonTokenPtr> getTokenRange(std::uint32_t start, std::uint32_t stop);
@@ -282,7 +392,7 @@ public:
     virtual String sourceName() override;
     virtual void consume() override;
     virtual std::uint32_t LA(std::int32_t i) override;
-    virtual ItemPtr LI(std::int32_t i) override { return LT(i); }
+    virtual Item LI(std::int32_t i) override { return LT(i); }
     
     virtual MarkerPtr mark() override;
     virtual Index index() override;
@@ -296,6 +406,7 @@ public:
     virtual String toString() override;
     virtual String toString(std::uint32_t start, std::uint32_t stop) override;
     virtual String toString(CommonTokenPtr start, CommonTokenPtr stop) override;
+    virtual StringView spanText(std::uint32_t start, std::uint32_t stop) override;
 };
 
 } // namespace antlr3
@@ -84,15 +84,13 @@ String TreeParser::getErrorMessage(Exception const * e, ConstString const * toke
 
     std::unique_ptr<Exception> ex = e->clone();
     
-    auto token = adaptor_->getToken(e->item);
+    auto token = adaptor_->getToken(e->item.ptr());
     if (!token)
     {
         assert(treeNodeStream() == ex->input);
-        ex->item.reset(
-            new CommonToken(
-                adaptor_->getType(e->item),
-                adaptor_->getText(e->item)
-            )
+        ex->item = makeShared<CommonToken>(
+            adaptor_->getType(e->item.ptr()),
+            adaptor_->getText(e->item.ptr())
         );
     }
     else
@@ -158,8 +156,8 @@ ItemPtr TreeParser::getMissingSymbol(
     return node;
 }
 
-std::uint32_t TreeParser::itemToInt(ItemPtr item) {
-    return adaptor_->getType(item);
+std::uint32_t TreeParser::itemToInt(Item const & item) {
+    return adaptor_->getType(item.ptr());
 }
 
 String TreeParser::traceCurrentItem() {
@@ -70,7 +70,7 @@ protected:
         return treeNodeStream()->LT(index);
     }
     
-    virtual std::uint32_t itemToInt(ItemPtr item) override;
+    virtual std::uint32_t itemToInt(Item const & item) override;
     virtual String traceCurrentItem() override;
 };
 
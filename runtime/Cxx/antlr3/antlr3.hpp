@@ -35,14 +35,23 @@
 #include <antlr3/Exception.hpp>
 #include <antlr3/String.hpp>
 #include <antlr3/CharStream.hpp>
+#include <antlr3/StreamingCharStream.hpp>
 #include <antlr3/CyclicDFA.hpp>
 #include <antlr3/IntStream.hpp>
+#include <antlr3/Item.hpp>
 #include <antlr3/RecognizerSharedState.hpp>
 #include <antlr3/BaseRecognizer.hpp>
 #include <antlr3/CommonToken.hpp>
+#include <antlr3/TokenFactory.hpp>
 #include <antlr3/TokenStream.hpp>
+#include <antlr3/CompactTokenStream.hpp>
+#include <antlr3/TokenCache.hpp>
+#include <antlr3/TokenRewriteStream.hpp>
+#include <antlr3/ConcurrentTokenStream.hpp>
 #include <antlr3/Bitset.hpp>
+#include <antlr3/CharSet.hpp>
 #include <antlr3/Lexer.hpp>
+#include <antlr3/ParallelLexer.hpp>
 #include <antlr3/Parser.hpp>
 #include <antlr3/TreeParser.hpp>
 #include <antlr3/BaseTreeAdaptor.hpp>
@@ -4,7 +4,7 @@
 #include <antlr3/antlr3.hpp>
 
 antlr3::CharStreamPtr makeCharStream(char const * text) {
-    return std::make_shared<antlr3::UnicodeCharStream>(
+    return antlr3::makeShared<antlr3::UnicodeCharStream>(
        text, (std::uint32_t)strlen(text),
        "test_input", antlr3::TextEncoding::UTF8
     );
@@ -13,7 +13,7 @@ antlr3::CharStreamPtr makeCharStream(char const * text) {
 template<class ParserT, class LexerT>
 antlr3::String execParser(void (ParserT::*method)(), char const * text) {
     auto inputStream = makeCharStream(text);
-    auto lexer = std::make_shared<LexerT>(inputStream);
+    auto lexer = antlr3::makeShared<LexerT>(inputStream);
     antlr3::CommonTokenStreamPtr tokenStream(new antlr3::CommonTokenStream(lexer));
     ParserT parser(tokenStream);
     (parser.*method)();
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <antlr3/antlr3.hpp>
+#include <chrono>
+#include <iostream>
+
+using namespace antlr3;
+
+// Benchmarks are disabled by default, run them with --gtest_also_run_disabled_tests.
+// Build once as is and once with -DANTLR3_SINGLE_THREADED=1 to compare reference counting policies.
+
+namespace {
+
+class RepeatSource : public TokenSource
+{
+public:
+    RepeatSource(CharStreamPtr input, std::size_t count)
+        : input_(std::move(input))
+        , count_(count)
+    {}
+
+    virtual CommonTokenPtr nextToken() override
+    {
+        CommonTokenPtr token = factory_.newToken();
+        token->setType(count_-- > 0 ? MinTokenType : TokenEof);
+        token->setInputStream(input_);
+        token->setStartIndex(0);
+        token->setStopIndex(1);
+        return token;
+    }
+
+    virtual LocationSourcePtr source() override { return input_; }
+private:
+    CharStreamPtr input_;
+    std::size_t count_;
+    PooledTokenFactory factory_;
+};
+
+template<class F>
+void measure(char const * name, std::size_t count, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::cout << name << ": " << ns / count << " ns per token" << std::endl;
+}
+
+} // namespace
+
+TEST(BenchmarkTest, DISABLED_benchmarkTokenStream)
+{
+    std::size_t const count = 2000000;
+    CharStreamPtr input = antlr3::makeShared<ByteCharStream>("x", 1, "bench");
+
+    CommonTokenStreamPtr stream;
+    measure("fill", count, [&] {
+        stream = antlr3::makeShared<CommonTokenStream>(antlr3::makeShared<RepeatSource>(input, count));
+        stream->LA(1);
+    });
+
+    std::size_t sum = 0;
+    measure("LT/consume", count, [&] {
+        for (std::size_t i = 0; i < count; ++i) {
+            CommonTokenPtr t1 = stream->LT(1);
+            CommonTokenPtr t2 = stream->LT(2);
+            sum += t1->type() + t2->type();
+            stream->consume();
+        }
+    });
+    ASSERT_GT(sum, 0u);
+
+    std::vector<CommonTokenPtr> tokens = stream->tokens();
+    measure("pointer copy", count, [&] {
+        std::vector<CommonTokenPtr> copy(tokens);
+        sum += copy.size();
+    });
+}
@@ -12,9 +12,9 @@ typedef std::string (*ParseFunc)(char const * data, std::uint32_t size);
 std::string parse(char const * data, std::uint32_t size)
 {
     auto nullDeleter = [](std::uint8_t const *) {};
-    auto inputStream = std::make_shared<antlr3::ByteCharStream>(data, size, nullDeleter, ANTLR3_T(""));
-    auto lexer = std::make_shared<CalcLexer>(inputStream);
-    auto tokenStream = std::make_shared<antlr3::CommonTokenStream>(lexer);
+    auto inputStream = antlr3::makeShared<antlr3::ByteCharStream>(data, size, nullDeleter, ANTLR3_T(""));
+    auto lexer = antlr3::makeShared<CalcLexer>(inputStream);
+    auto tokenStream = antlr3::makeShared<antlr3::CommonTokenStream>(lexer);
     CalcParser parser(tokenStream);
 
     parser_context ctx;
@@ -28,14 +28,14 @@ std::string parse(char const * data, std::uint32_t size)
 std::string parseWithAST(char const * data, std::uint32_t size)
 {
     auto nullDeleter = [](std::uint8_t const *) {};
-    auto inputStream = std::make_shared<antlr3::ByteCharStream>(data, size, nullDeleter, ANTLR3_T(""));
-    auto lexer = std::make_shared<CalcASTLexer>(inputStream);
-    auto tokenStream = std::make_shared<antlr3::CommonTokenStream>(lexer);
+    auto inputStream = antlr3::makeShared<antlr3::ByteCharStream>(data, size, nullDeleter, ANTLR3_T(""));
+    auto lexer = antlr3::makeShared<CalcASTLexer>(inputStream);
+    auto tokenStream = antlr3::makeShared<antlr3::CommonTokenStream>(lexer);
     CalcASTParser parser(tokenStream);
 
     CalcASTParser_prog_return r = parser.prog();
 
-    auto treeStream = std::make_shared<antlr3::CommonTreeNodeStream>(r.tree);
+    auto treeStream = antlr3::makeShared<antlr3::CommonTreeNodeStream>(r.tree);
     EvalAST treeParser(treeStream);
 
     parser_context2 ctx;
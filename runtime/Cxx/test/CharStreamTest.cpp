@@ -0,0 +1,277 @@
+#include <gtest/gtest.h>
+#include <antlr3/antlr3.hpp>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+
+using namespace antlr3;
+
+TEST(CharStreamTest, testStreamingWindow)
+{
+    std::string text;
+    for (int i = 0; i < 1000; ++i) {
+        text += "line " + std::to_string(i) + "\n";
+    }
+    std::istringstream in(text);
+    auto stream = antlr3::makeShared<StreamingCharStream>(in, "stream", 16);
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        ASSERT_EQ(stream->LA(1), std::uint32_t(text[i]));
+        stream->consume();
+        ASSERT_LE(stream->bufferedSize(), 48u);
+    }
+    ASSERT_EQ(stream->LA(1), CharstreamEof);
+    ASSERT_EQ(stream->location(stream->index()), Location(1001, 1));
+}
+
+TEST(CharStreamTest, testStreamingMarkerPinsInput)
+{
+    std::string text(1000, 'a');
+    text[500] = 'b';
+    std::istringstream in(text);
+    auto stream = antlr3::makeShared<StreamingCharStream>(in, "stream", 16);
+
+    stream->seek(500);
+    MarkerPtr m = stream->mark();
+    stream->seek(900);
+    ASSERT_GE(stream->bufferedSize(), 400u);
+    m->rewind();
+    ASSERT_EQ(stream->index(), 500u);
+    ASSERT_EQ(stream->LA(1), std::uint32_t('b'));
+    ASSERT_EQ(stream->substr(499, 502), String(ANTLR3_T("aba")));
+
+    m.reset();
+    stream->seek(990);
+    ASSERT_LE(stream->bufferedSize(), 48u);
+}
+
+TEST(CharStreamTest, testUTF8CodePoints)
+{
+    // 'a', U+0416, U+1F600, invalid byte, newline, 'b'
+    char const text[] = "a\xD0\x96\xF0\x9F\x98\x80\xFF\nb";
+    auto stream = antlr3::makeShared<UTF8CharStream>(text, std::uint32_t(sizeof(text) - 1), "utf8");
+
+    ASSERT_EQ(stream->LA(1), 0x61u);
+    ASSERT_EQ(stream->LA(2), 0x416u);
+    ASSERT_EQ(stream->LA(3), 0x1F600u);
+    ASSERT_EQ(stream->LA(4), 0xFFFDu);
+    ASSERT_EQ(stream->LA(5), 0x0Au);
+
+    stream->consume();
+    stream->consume();
+    ASSERT_EQ(stream->index(), 3u);
+    ASSERT_EQ(stream->LA(-1), 0x416u);
+    ASSERT_EQ(stream->location(stream->index()), Location(1, 3));
+    stream->consume();
+    ASSERT_EQ(stream->index(), 7u);
+    ASSERT_EQ(toUTF8(stream->substr(1, 7)), std::string("\xD0\x96\xF0\x9F\x98\x80"));
+
+    stream->consume();
+    stream->consume();
+    ASSERT_EQ(stream->LA(1), 0x62u);
+    ASSERT_EQ(stream->location(stream->index()), Location(2, 1));
+    stream->consume();
+    ASSERT_EQ(stream->LA(1), CharstreamEof);
+}
+
+TEST(CharStreamTest, testLazyLocation)
+{
+    char const text[] = "ab\ncd\n\nef";
+    auto stream = antlr3::makeShared<ByteCharStream>(text, std::uint32_t(sizeof(text) - 1), "bytes");
+
+    // Locations are available regardless of the current position
+    ASSERT_EQ(stream->location(8), Location(4, 2));
+    ASSERT_EQ(stream->location(3), Location(2, 1));
+    ASSERT_EQ(stream->location(2), Location(1, 3));
+    ASSERT_EQ(stream->location(6), Location(3, 1));
+
+    stream->seek(7);
+    ASSERT_EQ(stream->LA(1), std::uint32_t('e'));
+    ASSERT_EQ(stream->LA(-1), std::uint32_t('\n'));
+    stream->seek(1);
+    ASSERT_EQ(stream->LA(1), std::uint32_t('b'));
+
+    stream->setNewLineChar('c');
+    ASSERT_EQ(stream->location(8), Location(2, 5));
+}
+
+TEST(CharStreamTest, testCharItems)
+{
+    auto stream = antlr3::makeShared<ByteCharStream>("xy", 2, "bytes");
+    Item item = stream->LI(2);
+    ASSERT_TRUE(item.isChar());
+    ASSERT_EQ(item.toChar(), std::uint32_t('y'));
+    ASSERT_EQ(item.ptr(), nullptr);
+    ASSERT_EQ(stream->LI(3).toChar(), CharstreamEof);
+
+    Item token = antlr3::makeShared<CommonToken>(MinTokenType);
+    ASSERT_FALSE(token.isChar());
+    ASSERT_EQ(pointer_cast<CommonTokenPtr>(token)->type(), MinTokenType);
+}
+
+TEST(CharStreamTest, testCheckpoint)
+{
+    auto stream = antlr3::makeShared<ByteCharStream>("abc", 3, "bytes");
+    stream->consume();
+    Checkpoint cp = stream->checkpoint();
+    ASSERT_FALSE(cp.marker());
+    stream->consume();
+    stream->consume();
+    stream->restore(cp);
+    ASSERT_EQ(stream->LA(1), std::uint32_t('b'));
+
+    std::string text(100, 'a');
+    std::istringstream in(text);
+    auto streaming = antlr3::makeShared<StreamingCharStream>(in, "stream", 16);
+    Checkpoint pinned = streaming->checkpoint();
+    ASSERT_TRUE(bool(pinned.marker()));
+    for (int i = 0; i < 50; ++i) {
+        streaming->consume();
+    }
+    streaming->restore(pinned);
+    ASSERT_EQ(streaming->index(), 0u);
+}
+
+TEST(CharStreamTest, testConsumeLiteral)
+{
+    std::string text = "select \xD0\xB6x";
+    auto bytes = antlr3::makeShared<ByteCharStream>(text.data(), std::uint32_t(text.size()), "bytes");
+    ASSERT_FALSE(bytes->consumeLiteral("selects", 7));
+    ASSERT_FALSE(bytes->consumeLiteral(U"selecT", 6));
+    ASSERT_EQ(bytes->index(), 0u);
+    ASSERT_TRUE(bytes->consumeLiteral(U"select", 6));
+    ASSERT_TRUE(bytes->consumeLiteral(" ", 1));
+    ASSERT_EQ(bytes->index(), 7u);
+
+    auto utf8 = antlr3::makeShared<UTF8CharStream>(text.data(), std::uint32_t(text.size()), "utf8");
+    utf8->seek(7);
+    ASSERT_FALSE(utf8->consumeLiteral(u"жx", 2));
+    ASSERT_TRUE(utf8->consumeLiteral(u8"жx", 3));
+    ASSERT_EQ(utf8->LA(1), CharstreamEof);
+
+    auto unicode = antlr3::makeShared<UnicodeCharStream>(text.data(), 7, "unicode", TextEncoding::UTF8);
+    ASSERT_TRUE(unicode->consumeLiteral(u"sel", 3));
+    ASSERT_TRUE(unicode->consumeLiteral(U"ect", 3));
+    ASSERT_TRUE(unicode->consumeLiteral(" ", 1));
+    ASSERT_EQ(unicode->LA(1), CharstreamEof);
+}
+
+namespace {
+
+/// Writes \a text into a file in the test temp directory and returns its path.
+std::string writeTempFile(char const * name, std::string const & text)
+{
+    std::string path = testing::TempDir() + name;
+    std::ofstream out(path, std::ios::binary);
+    out << text;
+    return path;
+}
+
+} // namespace
+
+TEST(CharStreamTest, testMapFile)
+{
+    std::string text = "select \xD0\xB6x\nfrom";
+    std::string path = writeTempFile("CharStreamTest_map.txt", text);
+
+    ByteCharStream::DataRef data = ByteCharStream::mapFile(path.c_str());
+    ASSERT_TRUE(bool(data));
+    ASSERT_EQ(data.size(), text.size());
+    ASSERT_EQ(std::string(data.begin(), data.end()), text);
+
+    auto bytes = antlr3::makeShared<ByteCharStream>(ByteCharStream::mapFile(path.c_str()), "bytes");
+    ASSERT_EQ(bytes->size(), std::uint32_t(text.size()));
+    ASSERT_TRUE(bytes->consumeLiteral("select ", 7));
+    ASSERT_EQ(bytes->LA(1), 0xD0u);
+    ASSERT_EQ(bytes->location(text.size() - 4), Location(2, 1));
+    ASSERT_EQ(bytes->substr(text.size() - 4, text.size()), ANTLR3_T("from"));
+
+    // Decoding copies the data, so the mapping goes right after
+    auto unicode = antlr3::makeShared<UnicodeCharStream>(ByteCharStream::mapFile(path.c_str()), "unicode", TextEncoding::UTF8);
+    ASSERT_EQ(unicode->substr(0, 6), ANTLR3_T("select"));
+    unicode->seek(unicode->size() - 4);
+    ASSERT_EQ(unicode->LA(1), std::uint32_t('f'));
+    ASSERT_EQ(unicode->LA(-2), std::uint32_t('x'));
+    ASSERT_EQ(unicode->location(unicode->index()), Location(2, 1));
+
+    std::remove(path.c_str());
+}
+
+TEST(CharStreamTest, testMapEmptyFile)
+{
+    std::string path = writeTempFile("CharStreamTest_empty.txt", "");
+
+    ByteCharStream::DataRef data = ByteCharStream::mapFile(path.c_str());
+    ASSERT_TRUE(bool(data));
+    ASSERT_EQ(data.size(), 0u);
+
+    auto unicode = antlr3::makeShared<UnicodeCharStream>(data, "unicode", TextEncoding::UTF8);
+    ASSERT_EQ(unicode->LA(1), CharstreamEof);
+
+    auto bytes = antlr3::makeShared<ByteCharStream>(std::move(data), "bytes");
+    ASSERT_EQ(bytes->size(), 0u);
+    ASSERT_EQ(bytes->LA(1), CharstreamEof);
+
+    std::remove(path.c_str());
+}
+
+TEST(CharStreamTest, testMapMissingFile)
+{
+    std::string path = testing::TempDir() + "CharStreamTest_missing.txt";
+    std::remove(path.c_str());
+    ASSERT_FALSE(bool(ByteCharStream::mapFile(path.c_str())));
+
+    // Directories are not regular files
+    ASSERT_FALSE(bool(ByteCharStream::mapFile(testing::TempDir().c_str())));
+}
+
+TEST(CharStreamTest, testCharSet)
+{
+    CharSet set = CharSet::fromRanges({ '0', '9', 'A', 'Z', '_', '_', 0x400, 0x4FF, 0x1F600, 0x1F64F, 0x20000, 0x2A6DF });
+    ASSERT_TRUE(set.contains('0'));
+    ASSERT_TRUE(set.contains('Z'));
+    ASSERT_TRUE(set.contains('_'));
+    ASSERT_FALSE(set.contains('a'));
+    ASSERT_TRUE(set.contains(0x436));
+    ASSERT_FALSE(set.contains(0x500));
+    ASSERT_TRUE(set.contains(0x1F600));
+    ASSERT_FALSE(set.contains(0x1F650));
+    ASSERT_TRUE(set.contains(0x2A6DF));
+    ASSERT_FALSE(set.contains(0xFFFF));
+    ASSERT_FALSE(set.contains(CharstreamEof));
+    ASSERT_FALSE(CharSet().contains('a'));
+
+    // Ranges may overlap and nest
+    CharSet nested = CharSet::fromRanges({ 0x10000, 0x1FFFF, 0x10100, 0x10200, 0x15000, 0x20010, 0x20011, 0x20020 });
+    ASSERT_TRUE(nested.contains(0x10300));
+    ASSERT_TRUE(nested.contains(0x20000));
+    ASSERT_TRUE(nested.contains(0x20020));
+    ASSERT_FALSE(nested.contains(0x20021));
+    ASSERT_FALSE(nested.contains(0xFFFF));
+}
+
+TEST(CharStreamTest, testCaseFolding)
+{
+    std::string text = "Select \xD0\xB6x From";
+    auto utf8 = antlr3::makeShared<UTF8CharStream>(text.data(), std::uint32_t(text.size()), "utf8");
+    utf8->setCaseFolding(CaseFolding::Upper);
+    ASSERT_EQ(utf8->LA(1), std::uint32_t('S'));
+    ASSERT_EQ(utf8->LA(2), std::uint32_t('E'));
+    ASSERT_TRUE(utf8->consumeLiteral("SELECT ", 7));
+    ASSERT_EQ(utf8->LA(1), 0x436u);
+    ASSERT_EQ(utf8->LA(2), std::uint32_t('X'));
+    ASSERT_EQ(utf8->peek(1), 0x436u);
+    utf8->advance();
+    ASSERT_EQ(utf8->peek(1), std::uint32_t('X'));
+    ASSERT_EQ(utf8->LA(-1), 0x436u);
+    ASSERT_EQ(utf8->LA(-2), std::uint32_t(' '));
+    ASSERT_EQ(utf8->substr(0, 6), fromUTF8("Select"));
+    ASSERT_EQ(utf8->textView(utf8->index() + 2, utf8->index() + 6).str(), ANTLR3_T("From"));
+
+    auto bytes = antlr3::makeShared<ByteCharStream>(text.data(), std::uint32_t(text.size()), "bytes");
+    bytes->setCaseFolding(CaseFolding::Lower);
+    bytes->seek(text.size() - 4);
+    ASSERT_TRUE(bytes->consumeLiteral(U"from", 4));
+    bytes->setCaseFolding(CaseFolding::None);
+    ASSERT_EQ(bytes->LA(-4), std::uint32_t('F'));
+}
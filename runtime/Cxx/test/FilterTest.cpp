@@ -7,8 +7,8 @@ TEST(FilterTest, TestIt)
     auto data = u8",.,.abc=== !!!";
     auto size = strlen(data);
     auto nullDeleter = [](std::uint8_t const *) {};
-    auto inputStream = std::make_shared<antlr3::ByteCharStream>(data, size, nullDeleter, ANTLR3_T(""));
-    auto lexer = std::make_shared<Filter>(inputStream);
+    auto inputStream = antlr3::makeShared<antlr3::ByteCharStream>(data, size, nullDeleter, ANTLR3_T(""));
+    auto lexer = antlr3::makeShared<Filter>(inputStream);
     
     static uint32_t const tokens[] = {
         Filter::ID, Filter::WS, antlr3::TokenEof
@@ -19,3 +19,25 @@ TEST(FilterTest, TestIt)
         EXPECT_EQ(tokens[i], tok->type());
     }
 }
+
+TEST(FilterTest, TestSkipNonAscii)
+{
+    auto data = u8"--é€abc 12\né";
+    auto size = strlen(data);
+    auto nullDeleter = [](std::uint8_t const *) {};
+    auto inputStream = antlr3::makeShared<antlr3::ByteCharStream>(data, size, nullDeleter, ANTLR3_T(""));
+    auto lexer = antlr3::makeShared<Filter>(inputStream);
+    
+    static uint32_t const tokens[] = {
+        Filter::ID, Filter::WS, Filter::INT, Filter::NEWLINE, antlr3::TokenEof
+    };
+    static antlr3::Index const starts[] = { 7, 10, 11, 13 };
+    static size_t const n = std::end(tokens) - std::begin(tokens);
+    for (size_t i = 0; i < n; ++i) {
+        auto tok = lexer->nextToken();
+        EXPECT_EQ(tokens[i], tok->type());
+        if (i < n - 1) {
+            EXPECT_EQ(starts[i], tok->startIndex());
+        }
+    }
+}
@@ -0,0 +1,14 @@
+lexer grammar Keywords;
+
+options
+{
+    language=Cxx;
+    keywords=ID;
+}
+
+IF: 'if';
+ELSE: 'else';
+WHILE: 'while';
+ID: ('a'..'z'|'A'..'Z'|'_') ('a'..'z'|'A'..'Z'|'_'|'0'..'9')*;
+INT: ('0'..'9')+ ;
+WS: (' '|'\t'|'\r'|'\n')+ { $channel=antlr3::TokenHiddenChannel; };
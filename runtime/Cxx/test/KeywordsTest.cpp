@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include "generated/Keywords.hpp"
+
+
+TEST(KeywordsTest, TestIt)
+{
+    auto data = u8"if iffy else while1 while _if 42";
+    auto size = strlen(data);
+    auto nullDeleter = [](std::uint8_t const *) {};
+    auto inputStream = antlr3::makeShared<antlr3::ByteCharStream>(data, size, nullDeleter, ANTLR3_T(""));
+    auto lexer = antlr3::makeShared<Keywords>(inputStream);
+    
+    static uint32_t const tokens[] = {
+        Keywords::IF, Keywords::WS, Keywords::ID, Keywords::WS, Keywords::ELSE, Keywords::WS,
+        Keywords::ID, Keywords::WS, Keywords::WHILE, Keywords::WS, Keywords::ID, Keywords::WS,
+        Keywords::INT, antlr3::TokenEof
+    };
+    static size_t const n = std::end(tokens) - std::begin(tokens);
+    for (size_t i = 0; i < n; ++i) {
+        auto tok = lexer->nextToken();
+        EXPECT_EQ(tokens[i], tok->type());
+    }
+}
+
+TEST(KeywordsTest, TestCaseFolding)
+{
+    auto data = u8"IF Else wHiLe Iffy";
+    auto size = strlen(data);
+    auto nullDeleter = [](std::uint8_t const *) {};
+    auto inputStream = antlr3::makeShared<antlr3::ByteCharStream>(data, size, nullDeleter, ANTLR3_T(""));
+    inputStream->setCaseFolding(antlr3::CaseFolding::Lower);
+    auto lexer = antlr3::makeShared<Keywords>(inputStream);
+    
+    static uint32_t const tokens[] = {
+        Keywords::IF, Keywords::WS, Keywords::ELSE, Keywords::WS, Keywords::WHILE, Keywords::WS,
+        Keywords::ID, antlr3::TokenEof
+    };
+    static size_t const n = std::end(tokens) - std::begin(tokens);
+    for (size_t i = 0; i < n; ++i) {
+        auto tok = lexer->nextToken();
+        EXPECT_EQ(tokens[i], tok->type());
+    }
+}
@@ -0,0 +1,10 @@
+lexer grammar SkipRun;
+
+options
+{
+    language=Cxx;
+}
+
+ID: ('a'..'z'|'A'..'Z')+ ;
+INT: ('0'..'9')+ ;
+WS: (' '|'\t'|'\r'|'\n')+ { skip(); };
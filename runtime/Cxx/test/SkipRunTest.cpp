@@ -0,0 +1,25 @@
+#include <gtest/gtest.h>
+#include "generated/SkipRun.hpp"
+
+
+TEST(SkipRunTest, TestIt)
+{
+    auto data = u8"  foo \t 12\n bar\r\n";
+    auto size = strlen(data);
+    auto nullDeleter = [](std::uint8_t const *) {};
+    auto inputStream = antlr3::makeShared<antlr3::ByteCharStream>(data, size, nullDeleter, ANTLR3_T(""));
+    auto lexer = antlr3::makeShared<SkipRun>(inputStream);
+    
+    static uint32_t const tokens[] = {
+        SkipRun::ID, SkipRun::INT, SkipRun::ID, antlr3::TokenEof
+    };
+    static antlr3::Index const starts[] = { 2, 8, 12 };
+    static size_t const n = std::end(tokens) - std::begin(tokens);
+    for (size_t i = 0; i < n; ++i) {
+        auto tok = lexer->nextToken();
+        EXPECT_EQ(tokens[i], tok->type());
+        if (i < n - 1) {
+            EXPECT_EQ(starts[i], tok->startIndex());
+        }
+    }
+}
@@ -13,7 +13,7 @@ using namespace antlr3;
 TEST(TestLexer, testLocation)
 {
     auto inputStream = makeCharStream("34-31 22\n0 1\n14");
-    auto lexer = std::make_shared<P2Lexer>(inputStream);
+    auto lexer = antlr3::makeShared<P2Lexer>(inputStream);
     static struct { size_t offset, line, charPos; } const data[] = {
         {  0, 0, 0 }, // 34
         {  2, 0, 2 }, // -31
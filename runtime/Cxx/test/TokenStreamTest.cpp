@@ -0,0 +1,716 @@
+#include <gtest/gtest.h>
+#include <antlr3/antlr3.hpp>
+
+using namespace antlr3;
+
+namespace {
+
+/// Splits input into tokens at spaces; each word is a token of type MinTokenType,
+/// each space is a token of type MinTokenType + 1 on the hidden channel.
+class WordSource : public TokenSource
+{
+public:
+    WordSource(CharStreamPtr input)
+        : input_(std::move(input))
+        , index_(0)
+    {}
+
+    virtual CommonTokenPtr nextToken() override
+    {
+        ++calls;
+        auto token = antlr3::makeShared<CommonToken>();
+        token->setInputStream(input_);
+        token->setTokenIndex(index_++);
+        token->setStartIndex(input_->index());
+        if (input_->LA(1) == CharstreamEof) {
+            token->setType(TokenEof);
+        } else if (input_->LA(1) == ' ') {
+            token->setType(MinTokenType + 1);
+            token->setChannel(TokenHiddenChannel);
+            input_->consume();
+        } else {
+            token->setType(MinTokenType);
+            while (input_->LA(1) != ' ' && input_->LA(1) != CharstreamEof) {
+                input_->consume();
+            }
+        }
+        token->setStopIndex(input_->index());
+        return token;
+    }
+
+    virtual LocationSourcePtr source() override { return input_; }
+
+    /// Number of nextToken() calls so far.
+    std::size_t calls = 0;
+private:
+    CharStreamPtr input_;
+    Index index_;
+};
+
+/// Same tokens as WordSource, lexed by a Lexer; words may start with keyword "if".
+template<class Base>
+class WordLexer : public Base
+{
+public:
+    WordLexer(CharStreamPtr input)
+        : Base(input, nullptr)
+    {}
+
+    virtual void mTokens() override
+    {
+        if (this->LA(1) == ' ') {
+            this->matchc(' ');
+            this->state_->type = MinTokenType + 1;
+            this->state_->channel = TokenHiddenChannel;
+            return;
+        }
+        if (this->LA(1) == 'i' && this->LA(2) == 'f') {
+            this->matchs("if");
+        }
+        while (this->LA(1) != ' ' && this->LA(1) != CharstreamEof) {
+            this->matchRange(0, 0x10FFFF);
+        }
+        this->state_->type = MinTokenType;
+    }
+};
+
+CommonTokenStreamPtr makeStream(std::string const & text)
+{
+    CharStreamPtr input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "words", TextEncoding::UTF8);
+    return antlr3::makeShared<CommonTokenStream>(antlr3::makeShared<WordSource>(input));
+}
+
+} // namespace
+
+TEST(TokenStreamTest, testTextView)
+{
+    CommonTokenStreamPtr stream = makeStream("alpha beta gamma");
+    stream->LA(1);
+    CommonTokenPtr beta = stream->get(2);
+    StringView view = beta->textView();
+    ASSERT_FALSE(view.isNull());
+    ASSERT_EQ(view.str(), ANTLR3_T("beta"));
+
+    beta->setText(ANTLR3_T("BETA"));
+    ASSERT_TRUE(beta->textView() == StringView(ANTLR3_T("BETA"), 4));
+}
+
+TEST(TokenStreamTest, testSpanText)
+{
+    CommonTokenStreamPtr stream = makeStream("alpha beta gamma");
+    StringView span = stream->spanText(0, 3);
+    ASSERT_FALSE(span.isNull());
+    ASSERT_EQ(span.str(), ANTLR3_T("alpha beta"));
+    ASSERT_EQ(stream->toString(), ANTLR3_T("alpha beta gamma"));
+
+    // Overridden text breaks contiguity
+    stream->get(2)->setText(ANTLR3_T("BETA"));
+    ASSERT_TRUE(stream->spanText(0, 3).isNull());
+    ASSERT_EQ(stream->toString(0, 3), ANTLR3_T("alpha BETA"));
+}
+
+TEST(TokenStreamTest, testCompactStream)
+{
+    std::string text = "alpha beta gamma";
+    CharStreamPtr input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "words", TextEncoding::UTF8);
+    auto stream = antlr3::makeShared<CompactTokenStream>(antlr3::makeShared<WordSource>(input));
+    stream->setTokenTypeChannel(MinTokenType + 1, TokenHiddenChannel);
+
+    ASSERT_EQ(stream->size(), 6u);
+    ASSERT_EQ(stream->LA(1), MinTokenType);
+    ASSERT_EQ(stream->LA(3), MinTokenType);
+    ASSERT_EQ(stream->LA(4), TokenEof);
+    ASSERT_EQ(stream->LA(10), TokenEof);
+
+    stream->consume();
+    TokenHandle beta = stream->handle(1);
+    ASSERT_EQ(beta.tokenIndex(), 2u);
+    ASSERT_EQ(beta.textView().str(), ANTLR3_T("beta"));
+    ASSERT_EQ(stream->handle(-1).tokenIndex(), 0u);
+
+    CommonTokenPtr token = stream->LT(1);
+    ASSERT_EQ(token->tokenIndex(), 2u);
+    ASSERT_EQ(token->text(), ANTLR3_T("beta"));
+
+    // Repeated lookahead returns the same token
+    ASSERT_EQ(stream->LT(1).get(), token.get());
+    ASSERT_EQ(stream->get(2).get(), token.get());
+
+    ASSERT_EQ(stream->spanText(0, 5).str(), ANTLR3_T("alpha beta gamma"));
+    stream->setText(2, ANTLR3_T("BETA"));
+    ASSERT_TRUE(stream->spanText(0, 5).isNull());
+    ASSERT_EQ(stream->toString(), ANTLR3_T("alpha BETA gamma"));
+    ASSERT_EQ(stream->get(2)->text(), ANTLR3_T("BETA"));
+}
+
+TEST(TokenStreamTest, testPooledTokenFactory)
+{
+    PooledTokenFactory factory(4);
+    std::vector<CommonToken *> first;
+    for (int i = 0; i < 10; ++i) {
+        first.push_back(factory.newToken().get());
+    }
+    ASSERT_EQ(factory.size(), 10u);
+
+    // Recycled tokens do not keep their input alive
+    std::string text = "abc";
+    CharStreamPtr input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "abc", TextEncoding::UTF8);
+    first[9]->setInputStream(input);
+    first[9]->setText(ANTLR3_T("abc"));
+    ASSERT_EQ(input.use_count(), 2);
+
+    // Recycled tokens reuse the same memory
+    factory.reset();
+    ASSERT_EQ(input.use_count(), 1);
+    ASSERT_FALSE(first[9]->hasText());
+    ASSERT_EQ(factory.size(), 0u);
+    CommonTokenPtr recycled = factory.newToken();
+    ASSERT_EQ(recycled.get(), first[0]);
+    ASSERT_EQ(recycled->type(), TokenInvalid);
+
+    // Live tokens survive a reset
+    recycled->setType(MinTokenType);
+    factory.reset();
+    CommonTokenPtr fresh = factory.newToken();
+    ASSERT_NE(fresh.get(), recycled.get());
+    ASSERT_EQ(recycled->type(), MinTokenType);
+}
+
+TEST(TokenStreamTest, testLazyFill)
+{
+    std::string text = "a b c d e f g h";
+    CharStreamPtr input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "words", TextEncoding::UTF8);
+    auto source = antlr3::makeShared<WordSource>(input);
+    auto stream = antlr3::makeShared<CommonTokenStream>(source);
+    stream->setLazy(true);
+
+    ASSERT_EQ(stream->LT(1)->text(), ANTLR3_T("a"));
+    ASSERT_EQ(source->calls, 1u);
+    ASSERT_EQ(stream->LT(2)->text(), ANTLR3_T("b"));
+    ASSERT_EQ(source->calls, 3u);
+
+    ASSERT_EQ(stream->toString(), text);
+    ASSERT_EQ(stream->LA(9), TokenEof);
+}
+
+TEST(TokenStreamTest, testReleaseConsumed)
+{
+    std::string text;
+    for (int i = 0; i < 100; ++i) {
+        text += "w ";
+    }
+    CharStreamPtr input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "words", TextEncoding::UTF8);
+    auto stream = antlr3::makeShared<CommonTokenStream>(antlr3::makeShared<WordSource>(input));
+    stream->setReleaseConsumed(true);
+    stream->setIndexTokenTypes(true);
+
+    MarkerPtr marker;
+    for (int i = 0; i < 100; ++i) {
+        if (i == 50) {
+            marker = stream->mark();
+        }
+        ASSERT_EQ(stream->LA(1), MinTokenType);
+        ASSERT_EQ(stream->LT(-1) != nullptr, i > 0);
+        stream->consume();
+    }
+    ASSERT_EQ(stream->LA(1), TokenEof);
+
+    // Tokens after the marker are kept
+    marker->rewind();
+    ASSERT_EQ(stream->index(), 100u);
+    ASSERT_EQ(stream->LT(1)->tokenIndex(), 100u);
+    ASSERT_EQ(stream->get(100)->text(), ANTLR3_T("w"));
+    ASSERT_EQ(stream->tokens().size(), 101u);
+
+    // Text of released tokens is not available
+    ASSERT_EQ(stream->toString(0, 102), ANTLR3_T("w "));
+    ASSERT_EQ(stream->spanText(0, 102).str(), ANTLR3_T("w "));
+    ASSERT_EQ(stream->tokenIndicesOfType(MinTokenType, 0, 200).size(), 50u);
+}
+
+TEST(TokenStreamTest, testOnChannelLookahead)
+{
+    CommonTokenStreamPtr stream = makeStream("a b c");
+    ASSERT_EQ(stream->LA(1), MinTokenType);
+    ASSERT_EQ(stream->LA(3), MinTokenType);
+    ASSERT_EQ(stream->LA(4), TokenEof);
+    ASSERT_EQ(stream->LA(-1), TokenInvalid);
+
+    stream->consume();
+    ASSERT_EQ(stream->index(), 2u);
+    ASSERT_EQ(stream->LT(-1)->tokenIndex(), 0u);
+    ASSERT_EQ(stream->LT(2)->tokenIndex(), 4u);
+
+    stream->seek(1);
+    ASSERT_EQ(stream->LT(1)->tokenIndex(), 2u);
+    ASSERT_EQ(stream->LT(-1)->tokenIndex(), 0u);
+
+    // Channel overrides are applied as tokens are read
+    stream = makeStream("a b c");
+    stream->setTokenTypeChannel(MinTokenType + 1, TokenDefaultChannel);
+    ASSERT_EQ(stream->LA(2), MinTokenType + 1);
+    ASSERT_EQ(stream->LT(5)->tokenIndex(), 4u);
+}
+
+TEST(TokenStreamTest, testTokenRewriteStream)
+{
+    std::string text = "a b c d";
+    CharStreamPtr input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "words", TextEncoding::UTF8);
+    auto stream = antlr3::makeShared<TokenRewriteStream>(antlr3::makeShared<WordSource>(input));
+
+    stream->insertBefore(0, ANTLR3_T("<"));
+    stream->insertAfter(6, ANTLR3_T(">"));
+    stream->replace(2, ANTLR3_T("B"));
+    stream->insertBefore(2, ANTLR3_T("["));
+    stream->remove(4, 5);
+    stream->remove(3, 4);
+    ASSERT_EQ(stream->toString(), ANTLR3_T("<a [Bd>"));
+    ASSERT_EQ(stream->toString(0, 3), ANTLR3_T("<a [B"));
+    ASSERT_EQ(stream->toOriginalString(), text);
+
+    // Programs are independent and can be rolled back
+    stream->replace(0, 2, ANTLR3_T("x"), ANTLR3_T("other"));
+    ASSERT_EQ(stream->toString(ANTLR3_T("other"), 0, NullIndex), ANTLR3_T("x c d"));
+    stream->rollback(3);
+    ASSERT_EQ(stream->toString(), ANTLR3_T("<a B c d>"));
+    stream->deleteProgram();
+    ASSERT_EQ(stream->toString(), text);
+}
+
+TEST(TokenStreamTest, testParallelLexer)
+{
+    std::string text;
+    for (int i = 0; i < 100; ++i) {
+        text += "w" + std::to_string(i) + " ";
+    }
+    auto input = antlr3::makeShared<ByteCharStream>(text.data(), std::uint32_t(text.size()), "words");
+
+    // Words are split at spaces, so any position after a space is safe
+    auto splitAfterSpace = [](std::uint8_t const * data, Index size, Index pos) -> Index {
+        while (pos < size && data[pos - 1] != ' ') {
+            ++pos;
+        }
+        return pos;
+    };
+    auto lexer = antlr3::makeShared<ParallelLexer>(input, [](CharStreamPtr chunk) -> TokenSourcePtr {
+        return antlr3::makeShared<WordSource>(chunk);
+    }, splitAfterSpace, 4);
+    auto stream = antlr3::makeShared<CommonTokenStream>(lexer);
+
+    CommonTokenStreamPtr sequential = makeStream(text);
+    ASSERT_EQ(stream->size(), sequential->size());
+    ASSERT_EQ(lexer->chunkOffsets().size(), 4u);
+    for (Index i = 0; i < stream->size(); ++i) {
+        CommonTokenPtr expected = sequential->get(i);
+        CommonTokenPtr actual = stream->get(i);
+        ASSERT_EQ(actual->tokenIndex(), i);
+        ASSERT_EQ(actual->type(), expected->type());
+        ASSERT_EQ(actual->startIndex(), expected->startIndex());
+        ASSERT_EQ(actual->text(), expected->text());
+    }
+    ASSERT_EQ(stream->toString(), text);
+
+    // Errors of worker threads reach the caller, here chunks are split inside words
+    auto splitBeforeDigit = [](std::uint8_t const * data, Index size, Index pos) -> Index {
+        while (pos < size && !isdigit(data[pos])) {
+            ++pos;
+        }
+        return pos;
+    };
+    auto failing = antlr3::makeShared<ParallelLexer>(input, [](CharStreamPtr chunk) -> TokenSourcePtr {
+        if (chunk->LA(1) != 'w') {
+            throw std::runtime_error("chunk starts inside a word");
+        }
+        return antlr3::makeShared<WordSource>(chunk);
+    }, splitBeforeDigit, 4);
+    ASSERT_THROW(failing->nextToken(), std::runtime_error);
+}
+
+TEST(TokenStreamTest, testConcurrentTokenStream)
+{
+    std::string text;
+    for (int i = 0; i < 1000; ++i) {
+        text += "w" + std::to_string(i) + " ";
+    }
+    CharStreamPtr input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "words", TextEncoding::UTF8);
+    auto stream = antlr3::makeShared<ConcurrentTokenStream>(antlr3::makeShared<WordSource>(input), 4);
+
+    ASSERT_EQ(stream->LT(3)->text(), ANTLR3_T("w2"));
+    MarkerPtr marker = stream->mark();
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(stream->LT(1)->text(), fromUTF8("w" + std::to_string(i)));
+        stream->consume();
+    }
+    ASSERT_EQ(stream->LA(1), TokenEof);
+
+    marker->rewind();
+    ASSERT_EQ(stream->LT(1)->text(), ANTLR3_T("w0"));
+    ASSERT_EQ(stream->toString(), text);
+}
+
+TEST(TokenStreamTest, testConcurrentLocations)
+{
+    // Every line has a word followed by a character that fails to match,
+    // so the producer looks up error locations while the consumer reads token ones
+    class ErrorLexer : public Lexer
+    {
+    public:
+        ErrorLexer(CharStreamPtr input)
+            : Lexer(input, nullptr)
+        {}
+
+        virtual void mTokens() override
+        {
+            if (LA(1) == '!') {
+                matchc('?');
+                return;
+            }
+            while (LA(1) != '!' && LA(1) != CharstreamEof) {
+                matchRange(0, 0x10FFFF);
+            }
+            state_->type = MinTokenType;
+        }
+
+        virtual void reportError() override
+        {
+            ++errors;
+        }
+
+        std::size_t errors = 0;
+    };
+
+    std::string text;
+    for (int i = 0; i < 1000; ++i) {
+        text += "w" + std::to_string(i) + "!\n";
+    }
+    CharStreamPtr input = antlr3::makeShared<ByteCharStream>(text.data(), std::uint32_t(text.size()), "lines");
+    auto lexer = antlr3::makeShared<ErrorLexer>(input);
+    auto stream = antlr3::makeShared<ConcurrentTokenStream>(lexer, 4);
+
+    for (std::uint32_t i = 0; i < 1000; ++i) {
+        CommonTokenPtr token = stream->LT(1);
+        ASSERT_EQ(token->startLocation(), Location(i + 1, 1));
+        ASSERT_EQ(token->stopLocation().line(), i + 1);
+        stream->consume();
+    }
+    ASSERT_EQ(stream->LA(1), TokenEof);
+    ASSERT_EQ(lexer->errors, 1000u);
+}
+
+TEST(TokenStreamTest, testConcurrentSourceThrows)
+{
+    // Errors of the producer thread reach the consumer after the tokens before them
+    class FailingSource : public WordSource
+    {
+    public:
+        using WordSource::WordSource;
+
+        virtual CommonTokenPtr nextToken() override
+        {
+            CommonTokenPtr token = WordSource::nextToken();
+            if (token->tokenIndex() == 6) {
+                throw std::runtime_error("lexer action failed");
+            }
+            return token;
+        }
+    };
+
+    std::string text = "w0 w1 w2 w3 w4";
+    CharStreamPtr input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "words", TextEncoding::UTF8);
+    auto stream = antlr3::makeShared<ConcurrentTokenStream>(antlr3::makeShared<FailingSource>(input), 4);
+
+    ASSERT_EQ(stream->LT(3)->text(), ANTLR3_T("w2"));
+    ASSERT_THROW(stream->LT(4), std::runtime_error);
+
+    input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "words", TextEncoding::UTF8);
+    auto source = antlr3::makeShared<ConcurrentTokenSource>(antlr3::makeShared<FailingSource>(input), 2);
+    ASSERT_THROW({
+        for (int i = 0; i < 7; ++i) {
+            source->nextToken();
+        }
+    }, std::runtime_error);
+    ASSERT_THROW(source->nextToken(), std::runtime_error);
+}
+
+TEST(TokenStreamTest, testConcurrentTokenSourceDestroyedEarly)
+{
+    std::string text(10000, ' ');
+    CharStreamPtr input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "words", TextEncoding::UTF8);
+    auto source = antlr3::makeShared<ConcurrentTokenSource>(antlr3::makeShared<WordSource>(input), 16);
+    ASSERT_EQ(source->nextToken()->type(), MinTokenType + 1);
+}
+
+TEST(TokenStreamTest, testTokenCache)
+{
+    std::string text = "alpha beta gamma";
+    CharStreamPtr input = antlr3::makeShared<UnicodeCharStream>(text.data(), std::uint32_t(text.size()), "words", TextEncoding::UTF8);
+    auto stream = antlr3::makeShared<CommonTokenStream>(antlr3::makeShared<WordSource>(input));
+    stream->get(2)->setText(ANTLR3_T("BETA"));
+    std::uint64_t hash = TokenCache::hash(text.data(), text.size());
+
+    std::stringstream out;
+    ASSERT_TRUE(TokenCache::write(out, *stream, hash));
+    std::string bytes = out.str();
+    std::vector<std::uint32_t> data((bytes.size() + 3) / 4);
+    memcpy(data.data(), bytes.data(), bytes.size());
+
+    ASSERT_FALSE(TokenCache::load(data.data(), bytes.size(), hash + 1, input, text.size()));
+    ASSERT_FALSE(TokenCache::load(data.data(), bytes.size() - 1, hash, input, text.size()));
+
+    // Tokens must fit in the input
+    ASSERT_FALSE(TokenCache::load(data.data(), bytes.size(), hash, input, text.size() - 1));
+    std::vector<std::uint32_t> corrupt = data;
+    std::size_t starts = (32 + 2 * 6 * 4) / 4; // header, types, channels
+    ASSERT_EQ(corrupt[starts + 2], 6u);
+    corrupt[starts + 2] = 11;
+    ASSERT_FALSE(TokenCache::load(corrupt.data(), bytes.size(), hash, input, text.size()));
+
+    CompactTokenStreamPtr cached = TokenCache::load(data.data(), bytes.size(), hash, input, text.size());
+    ASSERT_TRUE(cached != nullptr);
+    ASSERT_EQ(cached->size(), stream->size());
+    ASSERT_EQ(cached->LA(1), MinTokenType);
+    ASSERT_EQ(cached->LA(4), TokenEof);
+    ASSERT_EQ(cached->channel(1), TokenHiddenChannel);
+    ASSERT_EQ(cached->text(2), ANTLR3_T("BETA"));
+    ASSERT_EQ(cached->toString(), ANTLR3_T("alpha BETA gamma"));
+    ASSERT_EQ(cached->sourceName(), ANTLR3_T("words"));
+
+    // Stream that released consumed tokens cannot be written
+    auto releasing = antlr3::makeShared<CommonTokenStream>(antlr3::makeShared<WordSource>(input));
+    input->seek(0);
+    releasing->setReleaseConsumed(true);
+    for (int i = 0; i < 3; ++i) {
+        releasing->consume();
+    }
+    std::stringstream released;
+    ASSERT_FALSE(TokenCache::write(released, *releasing, hash));
+}
+
+TEST(TokenStreamTest, testTokenTypeIndex)
+{
+    CommonTokenStreamPtr stream = makeStream("a b c d");
+    stream->setIndexTokenTypes(true);
+
+    Span<std::uint32_t> words = stream->tokenIndicesOfType(MinTokenType, 1, 6);
+    ASSERT_EQ(words.size(), 3u);
+    ASSERT_EQ(words[0], 2u);
+    ASSERT_EQ(words[2], 6u);
+    ASSERT_TRUE(stream->tokenIndicesOfType(MinTokenType + 2, 0, 6).empty());
+
+    std::vector<CommonTokenPtr> spaces = stream->getTokensType(0, 4, MinTokenType + 1);
+    ASSERT_EQ(spaces.size(), 2u);
+    ASSERT_EQ(spaces[1]->tokenIndex(), 3u);
+
+    std::vector<CommonTokenPtr> all = stream->getTokensList(2, 3, { MinTokenType, MinTokenType + 1 });
+    ASSERT_EQ(all.size(), 2u);
+    ASSERT_EQ(all[0]->tokenIndex(), 2u);
+
+    Span<CommonTokenPtr> tokens = stream->bufferedTokens();
+    ASSERT_EQ(tokens.size(), 8u);
+    ASSERT_EQ(tokens[7]->type(), TokenEof);
+}
+
+TEST(TokenStreamTest, testBasicLexer)
+{
+    std::string text = "if iffy \xD0\xB6\xD0\xB8\xD0\xB2 a";
+    auto input = antlr3::makeShared<UTF8CharStream>(text.data(), std::uint32_t(text.size()), "words");
+    auto generic = antlr3::makeShared<CommonTokenStream>(antlr3::makeShared<WordLexer<Lexer>>(input));
+    auto input2 = antlr3::makeShared<UTF8CharStream>(text.data(), std::uint32_t(text.size()), "words");
+    auto bound = antlr3::makeShared<CommonTokenStream>(antlr3::makeShared<WordLexer<BasicLexer<UTF8CharStream>>>(input2));
+
+    ASSERT_EQ(bound->size(), 8u);
+    ASSERT_EQ(bound->size(), generic->size());
+    for (Index i = 0; i < bound->size(); ++i) {
+        ASSERT_EQ(bound->get(i)->type(), generic->get(i)->type());
+        ASSERT_EQ(bound->get(i)->startIndex(), generic->get(i)->startIndex());
+        ASSERT_EQ(bound->get(i)->stopIndex(), generic->get(i)->stopIndex());
+    }
+    ASSERT_EQ(bound->get(4)->text(), fromUTF8("\xD0\xB6\xD0\xB8\xD0\xB2"));
+}
+
+TEST(TokenStreamTest, testKeywordClassification)
+{
+    // Mirrors the keywordType() that the Cxx target generates for keywords=...
+    class KeywordLexer : public WordLexer<Lexer>
+    {
+    public:
+        using WordLexer<Lexer>::WordLexer;
+
+        virtual void mTokens() override
+        {
+            WordLexer<Lexer>::mTokens();
+            if (state_->type == MinTokenType)
+            {
+                StringView view = textView();
+                switch (view.size())
+                {
+                case 2:
+                    if (equalsAscii(view, "if", 2)) state_->type = MinTokenType + 2;
+                    break;
+                case 4:
+                    if (equalsAscii(view, "else", 4)) state_->type = MinTokenType + 3;
+                    break;
+                }
+            }
+        }
+    };
+
+    std::string text = "if iffy else elsewhere";
+    CharStreamPtr input = antlr3::makeShared<UTF8CharStream>(text.data(), std::uint32_t(text.size()), "words");
+    auto stream = antlr3::makeShared<CommonTokenStream>(antlr3::makeShared<KeywordLexer>(input));
+    ASSERT_EQ(stream->size(), 8u);
+    ASSERT_EQ(stream->get(0)->type(), MinTokenType + 2);
+    ASSERT_EQ(stream->get(2)->type(), MinTokenType);
+    ASSERT_EQ(stream->get(4)->type(), MinTokenType + 3);
+    ASSERT_EQ(stream->get(6)->type(), MinTokenType);
+
+    ASSERT_FALSE(equalsAscii(StringView(ANTLR3_T("els"), 3), "else", 4));
+}
+
+TEST(TokenStreamTest, testKeywordClassificationFolded)
+{
+    // keywordType() compares the original spelling folded the way LA() sees it
+    class KeywordLexer : public WordLexer<Lexer>
+    {
+    public:
+        using WordLexer<Lexer>::WordLexer;
+
+        virtual void mTokens() override
+        {
+            WordLexer<Lexer>::mTokens();
+            if (state_->type == MinTokenType)
+            {
+                StringView view = textView();
+                CaseFolding folding = charStream()->caseFolding();
+                switch (view.size())
+                {
+                case 6:
+                    if (equalsAscii(view, "SELECT", 6, folding)) state_->type = MinTokenType + 2;
+                    break;
+                }
+            }
+        }
+    };
+
+    std::string text = "select SeLeCt SELECT selects";
+    auto input = antlr3::makeShared<UTF8CharStream>(text.data(), std::uint32_t(text.size()), "words");
+    input->setCaseFolding(CaseFolding::Upper);
+    auto stream = antlr3::makeShared<CommonTokenStream>(antlr3::makeShared<KeywordLexer>(input));
+    ASSERT_EQ(stream->size(), 8u);
+    ASSERT_EQ(stream->get(0)->type(), MinTokenType + 2);
+    ASSERT_EQ(stream->get(2)->type(), MinTokenType + 2);
+    ASSERT_EQ(stream->get(4)->type(), MinTokenType + 2);
+    ASSERT_EQ(stream->get(6)->type(), MinTokenType);
+    ASSERT_EQ(stream->get(2)->text(), ANTLR3_T("SeLeCt"));
+
+    ASSERT_TRUE(equalsAscii(StringView(ANTLR3_T("Else"), 4), "else", 4, CaseFolding::Lower));
+    ASSERT_FALSE(equalsAscii(StringView(ANTLR3_T("Else"), 4), "else", 4, CaseFolding::None));
+    ASSERT_FALSE(equalsAscii(StringView(ANTLR3_T("else"), 4), "else", 4, CaseFolding::Upper));
+}
+
+TEST(TokenStreamTest, testMatchLiteral)
+{
+    // Literal mismatch still goes through the per-character path and is reported there
+    class LiteralLexer : public WordLexer<BasicLexer<UTF8CharStream>>
+    {
+    public:
+        using WordLexer<BasicLexer<UTF8CharStream>>::WordLexer;
+
+        bool match(char const * literal)
+        {
+            return matchs(literal, strlen(literal));
+        }
+
+        RecognizerSharedState & sharedState() { return *state_; }
+    };
+
+    std::string text = "iffy";
+    auto input = antlr3::makeShared<UTF8CharStream>(text.data(), std::uint32_t(text.size()), "words");
+    LiteralLexer lexer(input);
+    ASSERT_TRUE(lexer.match("if"));
+    ASSERT_EQ(input->index(), 2u);
+    lexer.sharedState().backtracking = 1;
+    ASSERT_FALSE(lexer.match("fa"));
+    ASSERT_TRUE(lexer.sharedState().failed);
+    ASSERT_EQ(input->index(), 3u);
+}
+
+TEST(TokenStreamTest, testSkipChars)
+{
+    class SkipLexer : public WordLexer<Lexer>
+    {
+    public:
+        using WordLexer<Lexer>::WordLexer;
+
+        virtual void mTokens() override
+        {
+            ++calls;
+            if (LA(1) == ' ' || LA(1) == '\n') {
+                while (LA(1) == ' ' || LA(1) == '\n') {
+                    matchAny();
+                }
+                skip();
+                return;
+            }
+            WordLexer<Lexer>::mTokens();
+        }
+
+        std::size_t calls = 0;
+    };
+
+    std::string text = "  alpha \n beta  ";
+    auto input = antlr3::makeShared<UTF8CharStream>(text.data(), std::uint32_t(text.size()), "words");
+    auto lexer = antlr3::makeShared<SkipLexer>(input);
+    auto stream = antlr3::makeShared<CommonTokenStream>(lexer);
+    ASSERT_EQ(stream->size(), 3u);
+    ASSERT_EQ(stream->get(1)->text(), ANTLR3_T("beta"));
+    ASSERT_EQ(lexer->calls, 5u);
+
+    auto input2 = antlr3::makeShared<UTF8CharStream>(text.data(), std::uint32_t(text.size()), "words");
+    auto lexer2 = antlr3::makeShared<SkipLexer>(input2);
+    lexer2->setSkipChars(AsciiSet().add(' ').add('\n'));
+    auto stream2 = antlr3::makeShared<CommonTokenStream>(lexer2);
+    ASSERT_EQ(stream2->size(), 3u);
+    ASSERT_EQ(stream2->get(0)->startIndex(), 2u);
+    ASSERT_EQ(stream2->get(1)->text(), ANTLR3_T("beta"));
+    ASSERT_EQ(lexer2->calls, 2u);
+}
+
+TEST(TokenStreamTest, testFilterSkipChars)
+{
+    // Filter-mode lexer that extracts numbers, as a generated one with filter=true would
+    class NumberLexer : public Lexer
+    {
+    public:
+        NumberLexer(CharStreamPtr input)
+            : Lexer(input, nullptr)
+        {
+            filteringMode_ = true;
+        }
+
+        virtual void mTokens() override
+        {
+            ++calls;
+            if (LA(1) < '0' || LA(1) > '9') {
+                state_->failed = true;
+                return;
+            }
+            while (LA(1) >= '0' && LA(1) <= '9') {
+                matchAny();
+            }
+            state_->type = MinTokenType;
+        }
+
+        std::size_t calls = 0;
+    };
+
+    std::string text = "x = 12 \xD0\xB6 + 345;";
+    auto input = antlr3::makeShared<UTF8CharStream>(text.data(), std::uint32_t(text.size()), "numbers");
+    auto lexer = antlr3::makeShared<NumberLexer>(input);
+    lexer->setSkipChars(AsciiSet().add(0, '0' - 1).add('9' + 1, 127).addNonAscii());
+    auto stream = antlr3::makeShared<CommonTokenStream>(lexer);
+    ASSERT_EQ(stream->size(), 3u);
+    ASSERT_EQ(stream->get(0)->text(), ANTLR3_T("12"));
+    ASSERT_EQ(stream->get(1)->text(), ANTLR3_T("345"));
+    ASSERT_EQ(lexer->calls, 2u);
+}
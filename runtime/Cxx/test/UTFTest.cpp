@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include <antlr3/ConvertUTF.hpp>
+#include <vector>
+#include <string>
+#include <cstring>
 
 using namespace utf;
 
@@ -287,3 +290,63 @@ TEST(UTFTest, TestWriteUTF32)
     ASSERT_EQ(ConversionResult::TargetExhausted, Traits<UTF32>::Write(ptr, ptr, 0x10FFFF));
     ASSERT_EQ(buffer, ptr);
 }
+
+TEST(UTFTest, TestFindNonAscii)
+{
+    std::vector<UTF8> bytes(100, 'a');
+    for (size_t i = 0; i <= bytes.size(); ++i) {
+        if (i < bytes.size()) {
+            bytes[i] = 0xC3;
+        }
+        ASSERT_EQ(FindNonAscii(bytes.data(), bytes.data() + bytes.size()), bytes.data() + i);
+        if (i < bytes.size()) {
+            bytes[i] = 'a';
+        }
+    }
+
+    std::vector<UTF16> units(50, 'a');
+    units[37] = 0x100;
+    ASSERT_EQ(FindNonAscii(units.data(), units.data() + units.size()), units.data() + 37);
+    units[37] = 0x80;
+    ASSERT_EQ(FindNonAscii(units.data(), units.data() + units.size()), units.data() + 37);
+}
+
+TEST(UTFTest, TestConvertBuffer)
+{
+    // Long ASCII runs around multi-byte and invalid sequences
+    std::string ascii(40, 'x');
+    std::string src = ascii + "\xD0\x96" + ascii + "\xF0\x9F\x98\x80" + ascii + "\xFF" + ascii;
+
+    std::vector<UTF16> expected(src.size()), actual(src.size());
+    {
+        UTF8 const * s = reinterpret_cast<UTF8 const *>(src.data());
+        UTF16 * t = expected.data();
+        ConversionResult r = Convert<UTF8, UTF16>(s, s + src.size(), t, t + expected.size(), ConversionFlags::LenientConversion);
+        ASSERT_EQ(r, ConversionResult::ConversionOK);
+        expected.resize(t - expected.data());
+    }
+    {
+        UTF8 const * s = reinterpret_cast<UTF8 const *>(src.data());
+        DummyWriteIterator<UTF16> t(0), tEnd;
+        ConversionResult r = ConvertBuffer<UTF8, UTF16>(s, s + src.size(), t, tEnd, ConversionFlags::LenientConversion);
+        ASSERT_EQ(r, ConversionResult::ConversionOK);
+        ASSERT_EQ(t.pos(), expected.size());
+    }
+    {
+        UTF8 const * s = reinterpret_cast<UTF8 const *>(src.data());
+        UTF16 * t = actual.data();
+        ConversionResult r = ConvertBuffer<UTF8, UTF16>(s, s + src.size(), t, t + actual.size(), ConversionFlags::LenientConversion);
+        ASSERT_EQ(r, ConversionResult::ConversionOK);
+        actual.resize(t - actual.data());
+    }
+    ASSERT_EQ(actual, expected);
+
+    {
+        UTF8 const * s = reinterpret_cast<UTF8 const *>(src.data());
+        UTF16 * t = actual.data();
+        ConversionResult r = ConvertBuffer<UTF8, UTF16>(s, s + src.size(), t, t + 10, ConversionFlags::LenientConversion);
+        ASSERT_EQ(r, ConversionResult::TargetExhausted);
+        ASSERT_EQ(t, actual.data() + 10);
+        ASSERT_EQ(s, reinterpret_cast<UTF8 const *>(src.data()) + 10);
+    }
+}
@@ -0,0 +1,19 @@
+lexer grammar UnicodeId;
+
+options
+{
+    language=Cxx;
+    encoding='UTF32';
+}
+
+ID: LETTER (LETTER|'0'..'9')* ;
+INT: ('0'..'9')+ ;
+WS: (' '|'\t'|'\r'|'\n')+ { $channel=antlr3::TokenHiddenChannel; };
+
+fragment
+LETTER
+    : 'a'..'z' | 'A'..'Z' | '_'
+    | '\u00C0'..'\u00D6' | '\u00D8'..'\u00F6' | '\u00F8'..'\u02FF'
+    | '\u0370'..'\u037D' | '\u037F'..'\u1FFF'
+    | '\u3040'..'\u309F' | '\u4E00'..'\u9FFF'
+    ;
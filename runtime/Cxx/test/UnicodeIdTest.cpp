@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+#include "generated/UnicodeId.hpp"
+
+
+TEST(UnicodeIdTest, TestIt)
+{
+    auto data = u8"Ωmega straße 日本語 x9 42";
+    auto size = strlen(data);
+    auto nullDeleter = [](std::uint8_t const *) {};
+    auto inputStream = antlr3::makeShared<antlr3::UTF8CharStream>(data, size, nullDeleter, ANTLR3_T(""));
+    auto lexer = antlr3::makeShared<UnicodeId>(inputStream);
+    
+    static uint32_t const tokens[] = {
+        UnicodeId::ID, UnicodeId::WS, UnicodeId::ID, UnicodeId::WS, UnicodeId::ID, UnicodeId::WS,
+        UnicodeId::ID, UnicodeId::WS, UnicodeId::INT, antlr3::TokenEof
+    };
+    static antlr3::Index const starts[] = { 0, 6, 7, 14, 15, 24, 25, 27, 28 };
+    static size_t const n = std::end(tokens) - std::begin(tokens);
+    for (size_t i = 0; i < n; ++i) {
+        auto tok = lexer->nextToken();
+        EXPECT_EQ(tokens[i], tok->type());
+        if (i < n - 1) {
+            EXPECT_EQ(starts[i], tok->startIndex());
+        }
+    }
+}
@@ -443,10 +443,12 @@ public void cleanup( GrammarAST root )
     if ( grammarType == Grammar.LEXER )
     {
         String filter = (String)grammar.getOption( "filter" );
+        List<String> ruleNames =
+            grammar.extractKeywordRules( root, grammar.lexerRuleNamesInCombined );
         GrammarAST tokensRuleAST =
             grammar.addArtificialMatchTokensRule(
                 root,
-                grammar.lexerRuleNamesInCombined,
+                ruleNames,
                 grammar.getDelegateNames(),
                 filter != null && filter.equals( "true" ) );
     }
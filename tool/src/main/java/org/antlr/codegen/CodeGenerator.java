@@ -117,6 +117,14 @@ public class CodeGenerator {
 	/** Used to create unique labels */
 	protected int uniqueLabelNumber = 1;
 
+	/** Sets with at least this many intervals are tested through a lookup
+	 *  table, if the target defines lookaheadTableTest, instead of range by range.
+	 */
+	public static int MIN_INTERVALS_FOR_SET_TABLE = 8;
+
+	/** Names of the lookup tables declared so far, by set; equal sets share one */
+	protected Map<String, String> setTableNames = new HashMap<String, String>();
+
 	/** A reference to the ANTLR tool so we can learn about output directories
 	 *  and such.
 	 */
@@ -621,6 +629,27 @@ public class CodeGenerator {
 							 Utils.integer(elementIndex));
 	}
 
+	/** For large sets, such as Unicode identifier classes, declare a lookup
+	 *  table in the recognizer and test membership with a couple of loads.
+	 */
+	protected ST genSetTableExpr(STGroup templates,
+								 IntervalSet iset,
+								 int k,
+								 boolean partOfDFA)
+	{
+		String key = iset.toString();
+		String name = setTableNames.get(key);
+		if ( name==null ) {
+			name = "CHARSET_"+(setTableNames.size()+1);
+			setTableNames.put(key, name);
+			recognizerST.addAggr("setTables.{name,ranges}", name, iset.getIntervals());
+		}
+		ST eST = templates.getInstanceOf(partOfDFA ? "lookaheadTableTest" : "isolatedLookaheadTableTest");
+		eST.add("name", name);
+		eST.add("k", Utils.integer(k));
+		return eST;
+	}
+
 	// L O O K A H E A D  D E C I S I O N  G E N E R A T I O N
 
 	/** Generate code that computes the predicted alt given a DFA.  The
@@ -767,6 +796,11 @@ public class CodeGenerator {
 			emptyST.impl.name = "empty-set-expr";
 			return emptyST;
 		}
+		if ( templates.isDefined("lookaheadTableTest") &&
+			 iset.getIntervals().size()>=MIN_INTERVALS_FOR_SET_TABLE &&
+			 iset.getMinElement()>=0 ) {
+			return genSetTableExpr(templates, iset, k, partOfDFA);
+		}
 		String testSTName = "lookaheadTest";
 		String testRangeSTName = "lookaheadRangeTest";
 		String testSetSTName = "lookaheadSetTest";
@@ -211,7 +211,10 @@ public class ErrorManager {
     //
     public static final int MSG_CIRCULAR_DEPENDENCY = 213; // t1.g -> t2.g -> t3.g ->t1.g
 
-	public static final int MAX_MESSAGE_NUMBER = 213;
+	// keywords option warnings
+	public static final int MSG_KEYWORD_NOT_MATCHED = 214; // keyword rule kept in Tokens
+
+	public static final int MAX_MESSAGE_NUMBER = 214;
 
 	/** Do not do perform analysis if one of these happens */
 	public static final BitSet ERRORS_FORCING_NO_ANALYSIS = new BitSet() {
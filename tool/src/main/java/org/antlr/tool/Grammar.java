@@ -50,6 +50,7 @@ import org.antlr.grammar.v3.DefineGrammarItemsWalker;
 import org.antlr.grammar.v3.TreeToNFAConverter;
 import org.antlr.misc.Barrier;
 import org.antlr.misc.IntSet;
+import org.antlr.misc.Interval;
 import org.antlr.misc.IntervalSet;
 import org.antlr.misc.MultiMap;
 import org.antlr.misc.OrderedHashSet;
@@ -78,6 +79,7 @@ import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.BitSet;
 import java.util.Collection;
+import java.util.Collections;
 import java.util.HashMap;
 import java.util.HashSet;
 import java.util.Iterator;
@@ -85,6 +87,7 @@ import java.util.LinkedHashMap;
 import java.util.List;
 import java.util.Map;
 import java.util.Set;
+import java.util.TreeMap;
 import java.util.Vector;
 
 /** Represents a grammar in memory. */
@@ -250,6 +253,7 @@ public class Grammar {
 				add("backtrack");
 				add("memoize");
 				add("encoding");
+				add("keywords");
 				}
 			};
 
@@ -264,6 +268,7 @@ public class Grammar {
 				add("backtrack");
 				add("memoize");
 				add("encoding");
+				add("keywords");
 				}
 			};
 
@@ -447,6 +452,30 @@ public class Grammar {
 	 */
 	public List<String> lexerRuleNamesInCombined = new ArrayList<String>();
 
+	/** A lexer rule that matches a single identifier-shaped literal, such as
+	 *  SELECT : 'select' ;  When the keywords=ID option is in effect these
+	 *  rules are left out of the Tokens rule; the ID rule matches the run
+	 *  once and the generated code classifies its text.
+	 *
+	 *  This changes which rule wins when both match the same input: without
+	 *  the option the rule listed first does, with it the keyword always does,
+	 *  even if it is listed after ID.
+	 */
+	public static class Keyword implements Comparable<Keyword> {
+		public String text;
+		public String rule;
+		public Keyword(String text, String rule) {
+			this.text = text;
+			this.rule = rule;
+		}
+		public int getLength() { return text.length(); }
+		@Override
+		public int compareTo(Keyword other) { return text.compareTo(other.text); }
+	}
+
+	/** Keyword rules pulled out of the Tokens rule by the keywords option */
+	protected List<Keyword> keywords = new ArrayList<Keyword>();
+
 	/** Track the scopes defined outside of rules and the scopes associated
 	 *  with all rules (even if empty).
 	 */
@@ -941,6 +970,401 @@ public class Grammar {
 		return r;
 	}
 
+	/** Name of the lexer rule named by the keywords option, or null if the
+	 *  option is not set.  Only targets that generate a keyword classifier
+	 *  honour the option; for the others the lexer is built as usual.
+	 */
+	public String getKeywordsRuleName() {
+		if ( !isCxxLexer() ) {
+			return null;
+		}
+		return (String)getOption("keywords");
+	}
+
+	protected boolean isCxxLexer() {
+		return type==LEXER && "Cxx".equals(getOption("language"));
+	}
+
+	/** Find the lexer rules whose only alternative is an identifier-shaped
+	 *  string literal, remember them as keywords and return the remaining
+	 *  rule names, which are the ones the Tokens rule has to predict.
+	 *  The rule named by the keywords option has to match a literal for it
+	 *  to become a keyword; its generated code maps the matched text back to
+	 *  the keyword type.  Literals it does not match stay in the Tokens rule,
+	 *  with a warning.
+	 */
+	public List<String> extractKeywordRules(GrammarAST grammarAST,
+											List<String> ruleNames) {
+		String identRule = getKeywordsRuleName();
+		if ( identRule==null || !ruleNames.contains(identRule) ) {
+			return ruleNames;
+		}
+		Map<String, GrammarAST> rules = new HashMap<String, GrammarAST>();
+		for (int i = 0; i < grammarAST.getChildCount(); i++) {
+			GrammarAST r = (GrammarAST)grammarAST.getChild(i);
+			if ( r.getType()==ANTLRParser.RULE ) {
+				rules.put(r.getChild(0).getText(), r);
+			}
+		}
+		List<String> remaining = new ArrayList<String>();
+		for (String rname : ruleNames) {
+			GrammarAST r = rules.get(rname);
+			String literal = r!=null && !rname.equals(identRule) ? getKeywordLiteral(r) : null;
+			if ( literal!=null && !ruleMatchesLiteral(rules, identRule, literal) ) {
+				ErrorManager.grammarWarning(ErrorManager.MSG_KEYWORD_NOT_MATCHED,
+											this,
+											((GrammarAST)r.getChild(0)).getToken(),
+											rname,
+											identRule);
+				literal = null;
+			}
+			if ( literal!=null ) {
+				keywords.add(new Keyword(literal, rname));
+			}
+			else {
+				remaining.add(rname);
+			}
+		}
+		return remaining;
+	}
+
+	/** If rule r is just 'literal' and the literal looks like an identifier,
+	 *  return the unescaped literal; otherwise null.
+	 */
+	protected String getKeywordLiteral(GrammarAST r) {
+		GrammarAST block = (GrammarAST)r.getFirstChildWithType(ANTLRParser.BLOCK);
+		if ( block==null || block.getChildCount()!=2 ) { // ALT EOB
+			return null;
+		}
+		GrammarAST alt = (GrammarAST)block.getChild(0);
+		if ( alt.getType()!=ANTLRParser.ALT || alt.getChildCount()!=2 ) { // element EOA
+			return null;
+		}
+		GrammarAST element = (GrammarAST)alt.getChild(0);
+		if ( element.getType()!=ANTLRParser.STRING_LITERAL ) {
+			return null;
+		}
+		String text = getUnescapedStringFromGrammarStringLiteral(element.getText()).toString();
+		if ( text.length()==0 || !(Character.isLetter(text.charAt(0)) || text.charAt(0)=='_') ) {
+			return null;
+		}
+		for (int i = 0; i < text.length(); i++) {
+			char c = text.charAt(i);
+			if ( c>127 || !(Character.isLetterOrDigit(c) || c=='_') ) {
+				return null;
+			}
+		}
+		return text;
+	}
+
+	/** True if lexer rule ruleName matches all of text.  Keywords are taken
+	 *  out before NFAs are built, so this runs the rule over the same trees
+	 *  the NFA is built from, tracking every position a match can reach.
+	 *  Predicates and recursive rules cannot be decided this way; the
+	 *  literal is then assumed not to match.
+	 */
+	protected boolean ruleMatchesLiteral(Map<String, GrammarAST> rules,
+										 String ruleName,
+										 String text)
+	{
+		Set<Integer> start = new HashSet<Integer>();
+		start.add(0);
+		Set<Integer> end = matchRuleTree(rules, ruleName, text, start, new HashSet<String>());
+		return end!=null && end.contains(text.length());
+	}
+
+	protected Set<Integer> matchRuleTree(Map<String, GrammarAST> rules,
+										 String ruleName,
+										 String text,
+										 Set<Integer> positions,
+										 Set<String> active)
+	{
+		GrammarAST r = rules.get(ruleName);
+		if ( r==null || !active.add(ruleName) ) {
+			return null;
+		}
+		GrammarAST block = (GrammarAST)r.getFirstChildWithType(ANTLRParser.BLOCK);
+		Set<Integer> result = block!=null ? matchTree(rules, block, text, positions, active) : null;
+		active.remove(ruleName);
+		return result;
+	}
+
+	/** Positions in text where a match of element t can end, if it starts
+	 *  at any of the given positions; null if that cannot be decided.
+	 */
+	protected Set<Integer> matchTree(Map<String, GrammarAST> rules,
+									 GrammarAST t,
+									 String text,
+									 Set<Integer> positions,
+									 Set<String> active)
+	{
+		Set<Integer> result = new HashSet<Integer>();
+		switch ( t.getType() ) {
+			case ANTLRParser.BLOCK :
+				for (int i = 0; i < t.getChildCount(); i++) {
+					GrammarAST alt = (GrammarAST)t.getChild(i);
+					if ( alt.getType()!=ANTLRParser.ALT ) {
+						continue; // options, EOB
+					}
+					Set<Integer> altResult = matchTree(rules, alt, text, positions, active);
+					if ( altResult==null ) {
+						return null;
+					}
+					result.addAll(altResult);
+				}
+				return result;
+			case ANTLRParser.ALT :
+				result.addAll(positions);
+				for (int i = 0; i < t.getChildCount() && !result.isEmpty(); i++) {
+					GrammarAST e = (GrammarAST)t.getChild(i);
+					if ( e.getType()==ANTLRParser.EOA ) {
+						break;
+					}
+					result = matchTree(rules, e, text, result, active);
+					if ( result==null ) {
+						return null;
+					}
+				}
+				return result;
+			case ANTLRParser.STRING_LITERAL :
+				String literal = getUnescapedStringFromGrammarStringLiteral(t.getText()).toString();
+				for (int p : positions) {
+					if ( text.startsWith(literal, p) ) {
+						result.add(p + literal.length());
+					}
+				}
+				return result;
+			case ANTLRParser.CHAR_RANGE :
+				String lo = getUnescapedStringFromGrammarStringLiteral(t.getChild(0).getText()).toString();
+				String hi = getUnescapedStringFromGrammarStringLiteral(t.getChild(1).getText()).toString();
+				if ( lo.length()!=1 || hi.length()!=1 ) {
+					return null; // reported when the NFA is built
+				}
+				for (int p : positions) {
+					if ( p<text.length() && text.charAt(p)>=lo.charAt(0) && text.charAt(p)<=hi.charAt(0) ) {
+						result.add(p + 1);
+					}
+				}
+				return result;
+			case ANTLRParser.WILDCARD :
+				for (int p : positions) {
+					if ( p<text.length() ) {
+						result.add(p + 1);
+					}
+				}
+				return result;
+			case ANTLRParser.NOT :
+				// ~x matches one character that x does not match
+				for (int p : positions) {
+					if ( p>=text.length() ) {
+						continue;
+					}
+					Set<Integer> start = new HashSet<Integer>();
+					start.add(0);
+					Set<Integer> c = matchTree(rules, (GrammarAST)t.getChild(0),
+											   text.substring(p, p + 1), start, active);
+					if ( c==null ) {
+						return null;
+					}
+					if ( !c.contains(1) ) {
+						result.add(p + 1);
+					}
+				}
+				return result;
+			case ANTLRParser.TOKEN_REF :
+				return matchRuleTree(rules, t.getText(), text, positions, active);
+			case ANTLRParser.OPTIONAL :
+				Set<Integer> optional = matchTree(rules, (GrammarAST)t.getChild(0), text, positions, active);
+				if ( optional==null ) {
+					return null;
+				}
+				result.addAll(positions);
+				result.addAll(optional);
+				return result;
+			case ANTLRParser.CLOSURE :
+			case ANTLRParser.POSITIVE_CLOSURE :
+				GrammarAST body = (GrammarAST)t.getChild(0);
+				Set<Integer> next = new HashSet<Integer>(positions);
+				if ( t.getType()==ANTLRParser.POSITIVE_CLOSURE ) {
+					Set<Integer> first = matchTree(rules, body, text, positions, active);
+					if ( first==null ) {
+						return null;
+					}
+					next = new HashSet<Integer>(first);
+				}
+				// Every iteration consumes input or adds no new positions
+				while ( !next.isEmpty() ) {
+					next.removeAll(result);
+					result.addAll(next);
+					if ( next.isEmpty() ) {
+						break;
+					}
+					next = matchTree(rules, body, text, next, active);
+					if ( next==null ) {
+						return null;
+					}
+				}
+				return result;
+			case ANTLRParser.ASSIGN :
+			case ANTLRParser.PLUS_ASSIGN :
+				return matchTree(rules, (GrammarAST)t.getChild(1), text, positions, active);
+			case ANTLRParser.ACTION :
+			case ANTLRParser.FORCED_ACTION :
+			case ANTLRParser.EPSILON :
+			case ANTLRParser.SYNPRED :
+				return positions;
+			default :
+				return null;
+		}
+	}
+
+	/** Keywords grouped by length and sorted within a group; the code
+	 *  generator switches on the length and compares within the group.
+	 */
+	public List<List<Keyword>> getKeywordsByLength() {
+		Map<Integer, List<Keyword>> groups = new TreeMap<Integer, List<Keyword>>();
+		for (Keyword k : keywords) {
+			List<Keyword> group = groups.get(k.getLength());
+			if ( group==null ) {
+				group = new ArrayList<Keyword>();
+				groups.put(k.getLength(), group);
+			}
+			group.add(k);
+		}
+		List<List<Keyword>> result = new ArrayList<List<Keyword>>();
+		for (List<Keyword> group : groups.values()) {
+			Collections.sort(group);
+			result.add(group);
+		}
+		return result;
+	}
+
+	/** ASCII characters the Cxx lexer skips in bulk before predicting each
+	 *  token, without entering any rule or creating a token; null if none.
+	 *
+	 *  If a lexer rule is just a skipped run of ASCII characters, such as
+	 *  WS : (' '|'\t'|'\r'|'\n')+ {skip();} ; and no other token can start
+	 *  with those characters, these are the characters of the run.
+	 *
+	 *  In filter mode, these are the characters that cannot start any token:
+	 *  the lexer would try and fail to match each of them in turn.
+	 */
+	public List<Interval> getSkipRunChars() {
+		IntervalSet chars = getSkipChars();
+		return chars==null ? null : chars.and(IntervalSet.of(0, 127)).getIntervals();
+	}
+
+	/** In filter mode, true if no token can start with a non-ASCII character,
+	 *  so that the lexer skips those in bulk as well.
+	 */
+	public boolean getSkipNonAscii() {
+		IntervalSet chars = getSkipChars();
+		return chars!=null && chars.member(128);
+	}
+
+	protected IntervalSet getSkipChars() {
+		if ( !isCxxLexer() || getDelegateNames().size()>0 ) {
+			return null;
+		}
+		if ( "true".equals(getOption("filter")) ) {
+			return getFilterSkipChars();
+		}
+		Rule skipRule = null;
+		IntervalSet chars = null;
+		for (Rule r : getRules()) {
+			IntervalSet s = getSkipRunSet(r);
+			if ( s!=null ) {
+				skipRule = r;
+				chars = s;
+				break;
+			}
+		}
+		if ( skipRule==null ) {
+			return null;
+		}
+		for (Rule r : getRules()) {
+			if ( r==skipRule || r.isTokensRule() || r.isSynPred ||
+				 "fragment".equals(r.modifier) ) {
+				continue;
+			}
+			LookaheadSet first = FIRST(getRuleStartState(r.name));
+			if ( first==null || !first.tokenTypeSet.and(chars).isNil() ) {
+				return null;
+			}
+		}
+		return chars;
+	}
+
+	/** Characters outside FIRST(Tokens); non-ASCII ones only as a whole */
+	protected IntervalSet getFilterSkipChars() {
+		NFAState tokensStart = getRuleStartState(ARTIFICIAL_TOKENS_RULENAME);
+		LookaheadSet first = tokensStart!=null ? FIRST(tokensStart) : null;
+		if ( first==null ) {
+			return null;
+		}
+		IntervalSet chars = IntervalSet.of(0, 127).subtract(first.tokenTypeSet);
+		if ( first.tokenTypeSet.and(IntervalSet.of(128, Label.MAX_CHAR_VALUE)).isNil() ) {
+			chars.add(128, Label.MAX_CHAR_VALUE);
+		}
+		return chars.isNil() ? null : chars;
+	}
+
+	/** Characters matched by rule r if it has the form (c1|c2|'a'..'z')+ {skip();} */
+	protected IntervalSet getSkipRunSet(Rule r) {
+		if ( r.tree==null || "fragment".equals(r.modifier) ) {
+			return null;
+		}
+		GrammarAST block = (GrammarAST)r.tree.getFirstChildWithType(ANTLRParser.BLOCK);
+		if ( block==null || block.getChildCount()!=2 ) { // ALT EOB
+			return null;
+		}
+		GrammarAST alt = (GrammarAST)block.getChild(0);
+		if ( alt.getType()!=ANTLRParser.ALT || alt.getChildCount()!=3 ) { // (...)+ ACTION EOA
+			return null;
+		}
+		GrammarAST closure = (GrammarAST)alt.getChild(0);
+		GrammarAST action = (GrammarAST)alt.getChild(1);
+		if ( closure.getType()!=ANTLRParser.POSITIVE_CLOSURE ||
+			 action.getType()!=ANTLRParser.ACTION ||
+			 !action.getText().replaceAll("\\s", "").equals("skip();") ) {
+			return null;
+		}
+		GrammarAST set = (GrammarAST)closure.getChild(0);
+		IntervalSet chars = new IntervalSet();
+		for (int i = 0; i < set.getChildCount(); i++) {
+			GrammarAST a = (GrammarAST)set.getChild(i);
+			if ( a.getType()==ANTLRParser.EOB ) {
+				break;
+			}
+			if ( a.getType()!=ANTLRParser.ALT || a.getChildCount()!=2 ) {
+				return null;
+			}
+			GrammarAST e = (GrammarAST)a.getChild(0);
+			int lo, hi;
+			if ( e.getType()==ANTLRParser.STRING_LITERAL ) {
+				lo = hi = getSingleCharValue(e.getText());
+			}
+			else if ( e.getType()==ANTLRParser.CHAR_RANGE ) {
+				lo = getSingleCharValue(e.getChild(0).getText());
+				hi = getSingleCharValue(e.getChild(1).getText());
+			}
+			else {
+				return null;
+			}
+			if ( lo<0 || hi>=128 || lo>hi ) {
+				return null;
+			}
+			chars.add(lo, hi);
+		}
+		return chars.isNil() ? null : chars;
+	}
+
+	/** The char of a one-char literal such as '\t'; -1 for longer literals */
+	protected static int getSingleCharValue(String literal) {
+		StringBuffer s = getUnescapedStringFromGrammarStringLiteral(literal);
+		return s.length()==1 ? s.charAt(0) : -1;
+	}
+
 	public GrammarAST parseArtificialRule(String ruleText) {
 		ANTLRLexer lexer = new ANTLRLexer(new ANTLRStringStream(ruleText));
 		ANTLRParser parser = ANTLRParser.createParser(new CommonTokenStream(lexer));
@@ -518,6 +518,11 @@ public class Rule {
 		return name.equals(Grammar.ARTIFICIAL_TOKENS_RULENAME);
 	}
 
+	/** Is this the identifier rule named by the keywords option? */
+	public boolean isKeywordsRule() {
+		return name.equals(grammar.getKeywordsRuleName());
+	}
+
 	public Map<String, Object> getActions() {
 		return actions;
 	}
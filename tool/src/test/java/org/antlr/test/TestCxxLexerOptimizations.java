@@ -0,0 +1,324 @@
+/*
+ * [The "BSD license"]
+ *  Copyright (c) 2010 Terence Parr
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *  1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ *  IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ *  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ *  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ *  NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+package org.antlr.test;
+
+import org.antlr.Tool;
+import org.antlr.codegen.CodeGenerator;
+import org.antlr.tool.*;
+import org.junit.Test;
+import org.stringtemplate.v4.ST;
+
+import java.util.List;
+
+import static org.junit.Assert.*;
+
+/** Lexer shortcuts that only the Cxx target generates code for */
+public class TestCxxLexerOptimizations extends BaseTest {
+
+	/** Public default constructor used by TestRig */
+	public TestCxxLexerOptimizations() {
+	}
+
+	@Test public void testKeywordsExtracted() throws Exception {
+		ErrorQueue equeue = new ErrorQueue();
+		ErrorManager.setErrorListener(equeue);
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; keywords=ID; }\n" +
+			"WHILE : 'while' ;\n" +
+			"IF : 'if' ;\n" +
+			"DO : 'do' ;\n" +
+			"ID : ('a'..'z'|'_')+ ;\n" +
+			"INT : ('0'..'9')+ ;\n");
+		assertEquals("[[do:DO, if:IF], [while:WHILE]]", keywordsToString(g));
+		String tokens = g.getRule(Grammar.ARTIFICIAL_TOKENS_RULENAME).tree.toStringTree();
+		assertFalse(tokens, tokens.contains("WHILE"));
+		assertFalse(tokens, tokens.contains("IF"));
+		assertTrue(tokens, tokens.contains("ID"));
+		assertTrue(tokens, tokens.contains("INT"));
+		assertEquals("unexpected errors: "+equeue, 0, equeue.size());
+	}
+
+	@Test public void testKeywordsOnlyForCxx() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { keywords=ID; }\n" +
+			"IF : 'if' ;\n" +
+			"ID : ('a'..'z')+ ;\n");
+		assertEquals("[]", keywordsToString(g));
+		String tokens = g.getRule(Grammar.ARTIFICIAL_TOKENS_RULENAME).tree.toStringTree();
+		assertTrue(tokens, tokens.contains("IF"));
+	}
+
+	@Test public void testNonIdentifierLiteralIsNotKeyword() throws Exception {
+		ErrorQueue equeue = new ErrorQueue();
+		ErrorManager.setErrorListener(equeue);
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; keywords=ID; }\n" +
+			"IF : 'if' ;\n" +
+			"ARROW : '->' ;\n" +
+			"IFS : 'if' 's' ;\n" +
+			"ID : ('a'..'z')+ ;\n");
+		assertEquals("[[if:IF]]", keywordsToString(g));
+		assertEquals("unexpected errors: "+equeue, 0, equeue.size());
+	}
+
+	@Test public void testKeywordNotMatchedByIdentRule() throws Exception {
+		ErrorQueue equeue = new ErrorQueue();
+		ErrorManager.setErrorListener(equeue);
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; keywords=ID; }\n" +
+			"IF : 'if' ;\n" +
+			"DO_IT : 'do_it' ;\n" +
+			"ID : ('a'..'z')+ ;\n");
+		assertEquals("[[if:IF]]", keywordsToString(g));
+		String tokens = g.getRule(Grammar.ARTIFICIAL_TOKENS_RULENAME).tree.toStringTree();
+		assertTrue(tokens, tokens.contains("DO_IT"));
+
+		GrammarSemanticsMessage expectedMessage =
+			new GrammarSemanticsMessage(ErrorManager.MSG_KEYWORD_NOT_MATCHED, g, null, "DO_IT");
+		checkGrammarSemanticsWarning(equeue, expectedMessage);
+	}
+
+	@Test public void testKeywordMatchedThroughFragment() throws Exception {
+		ErrorQueue equeue = new ErrorQueue();
+		ErrorManager.setErrorListener(equeue);
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; keywords=ID; }\n" +
+			"FOR : 'for' ;\n" +
+			"FOR_EACH : 'for_each' ;\n" +
+			"ID : LETTER (LETTER|'_')* ;\n" +
+			"fragment LETTER : 'a'..'z' ;\n");
+		assertEquals("[[for:FOR], [for_each:FOR_EACH]]", keywordsToString(g));
+		assertEquals("unexpected warnings: "+equeue, 0, equeue.warnings.size());
+	}
+
+	@Test public void testSkipRun() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; }\n" +
+			"ID : ('a'..'z')+ ;\n" +
+			"WS : (' '|'\\t'|'\\r'|'\\n')+ {skip();} ;\n");
+		g.buildNFA();
+		assertEquals("[9..10, 13..13, 32..32]", String.valueOf(g.getSkipRunChars()));
+		assertFalse(g.getSkipNonAscii());
+	}
+
+	@Test public void testSkipRunWithRange() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; }\n" +
+			"ID : ('a'..'z')+ ;\n" +
+			"CTRL : ('\\u0001'..' ')+ { skip(); } ;\n");
+		g.buildNFA();
+		assertEquals("[1..32]", String.valueOf(g.getSkipRunChars()));
+	}
+
+	@Test public void testSkipRunRejectedWhenTokenStartsWithRunChar() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; }\n" +
+			"ID : ('a'..'z')+ ;\n" +
+			"INDENT : '\\n' Spaces ;\n" +
+			"fragment Spaces : ' '+ ;\n" +
+			"WS : (' '|'\\n')+ {skip();} ;\n");
+		g.buildNFA();
+		assertNull(g.getSkipRunChars());
+	}
+
+	@Test public void testSkipRunIgnoresFragments() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; }\n" +
+			"ID : ('a'..'z')+ Spaces? ;\n" +
+			"fragment Spaces : ' '+ ;\n" +
+			"WS : (' '|'\\n')+ {skip();} ;\n");
+		g.buildNFA();
+		assertEquals("[10..10, 32..32]", String.valueOf(g.getSkipRunChars()));
+	}
+
+	@Test public void testSkipRunNeedsSkip() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; }\n" +
+			"ID : ('a'..'z')+ ;\n" +
+			"WS : (' '|'\\n')+ {$channel=HIDDEN;} ;\n");
+		g.buildNFA();
+		assertNull(g.getSkipRunChars());
+	}
+
+	@Test public void testSkipRunNeedsSingleChars() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; }\n" +
+			"ID : ('a'..'z')+ ;\n" +
+			"WS : (' '|'\\r\\n')+ {skip();} ;\n");
+		g.buildNFA();
+		assertNull(g.getSkipRunChars());
+	}
+
+	@Test public void testSkipRunOnlyForCxx() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"ID : ('a'..'z')+ ;\n" +
+			"WS : (' '|'\\n')+ {skip();} ;\n");
+		g.buildNFA();
+		assertNull(g.getSkipRunChars());
+	}
+
+	@Test public void testFilterSkipChars() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; filter=true; }\n" +
+			"ID : ('a'..'z')+ ;\n" +
+			"INT : ('0'..'9')+ ;\n");
+		g.buildNFA();
+		assertEquals("[0..47, 58..96, 123..127]", String.valueOf(g.getSkipRunChars()));
+		assertTrue(g.getSkipNonAscii());
+	}
+
+	@Test public void testFilterSkipCharsWithNonAsciiToken() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; filter=true; }\n" +
+			"ID : ('a'..'z')+ ;\n" +
+			"E : '\\u00e9'+ ;\n");
+		g.buildNFA();
+		assertEquals("[0..96, 123..127]", String.valueOf(g.getSkipRunChars()));
+		assertFalse(g.getSkipNonAscii());
+	}
+
+	@Test public void testFilterSkipCharsWithNotSet() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; filter=true; }\n" +
+			"NOT_X : ~'x' ;\n");
+		g.buildNFA();
+		assertEquals("[120..120]", String.valueOf(g.getSkipRunChars()));
+		assertFalse(g.getSkipNonAscii());
+	}
+
+	@Test public void testFilterSkipCharsWithWildcard() throws Exception {
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; filter=true; }\n" +
+			"ID : ('a'..'z')+ ;\n" +
+			"ANY : . ;\n");
+		g.buildNFA();
+		assertNull(g.getSkipRunChars());
+		assertFalse(g.getSkipNonAscii());
+	}
+
+	@Test public void testLargeSetUsesTable() throws Exception {
+		ErrorQueue equeue = new ErrorQueue();
+		ErrorManager.setErrorListener(equeue);
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; }\n" +
+			"ID : ('a'|'c'|'e'|'g'|'i'|'k'|'m'|'o')+ ;\n" +
+			"UID : '_' ('a'|'c'|'e'|'g'|'i'|'k'|'m'|'o') ;\n" +
+			"XZ : ('x'|'z')+ ;\n");
+		String found = genCxxRecognizer(g);
+		assertEquals("unexpected errors: "+equeue, 0, equeue.errors.size());
+		// the same set in the Tokens DFA, ID's loop and UID shares one table
+		assertEquals(1, countOccurrences(found, "antlr3::CharSet const "));
+		assertTrue(found, found.contains(
+			"static antlr3::CharSet const CHARSET_1 = antlr3::CharSet::fromRanges({ " +
+			"97, 97, 99, 99, 101, 101, 103, 103, 105, 105, 107, 107, 109, 109, 111, 111 });"));
+		assertTrue(found, found.contains("CHARSET_1.contains(LA(1))"));
+		assertFalse(found, found.contains("CHARSET_2"));
+	}
+
+	@Test public void testSetTableDoesNotClashWithSetLabels() throws Exception {
+		ErrorQueue equeue = new ErrorQueue();
+		ErrorManager.setErrorListener(equeue);
+		Grammar g = new Grammar(
+			"parser grammar t;\n" +
+			"options { language=Cxx; output=AST; }\n" +
+			"tokens { A; B; C; D; E; F; G; H; I; J; K; L; M; N; O; P; }\n" +
+			"a : (A|C|E|G|I|K|M|O) ;\n");
+		String found = genCxxRecognizer(g);
+		assertEquals("unexpected errors: "+equeue, 0, equeue.errors.size());
+		// the set element gets a generated setN label of its own
+		assertTrue(found, found.contains("CHARSET_1.contains(LA(1))"));
+		assertFalse(found, found.contains("set1.contains("));
+	}
+
+	@Test public void testSmallSetUsesComparisons() throws Exception {
+		ErrorQueue equeue = new ErrorQueue();
+		ErrorManager.setErrorListener(equeue);
+		Grammar g = new Grammar(
+			"lexer grammar t;\n" +
+			"options { language=Cxx; }\n" +
+			"ID : ('a'|'c'|'e'|'g'|'i'|'k'|'m')+ ;\n");
+		assertEquals(8, CodeGenerator.MIN_INTERVALS_FOR_SET_TABLE);
+		String found = genCxxRecognizer(g);
+		assertEquals("unexpected errors: "+equeue, 0, equeue.errors.size());
+		assertFalse(found, found.contains("antlr3::CharSet"));
+	}
+
+	protected String genCxxRecognizer(Grammar g) {
+		Tool antlr = newTool();
+		CodeGenerator generator = new CodeGenerator(antlr, g, "Cxx");
+		g.setCodeGenerator(generator);
+		ST outputFileST = generator.genRecognizer();
+		assertNotNull(outputFileST);
+		return outputFileST.render();
+	}
+
+	protected static int countOccurrences(String s, String sub) {
+		int n = 0;
+		for (int i = s.indexOf(sub); i>=0; i = s.indexOf(sub, i+sub.length())) {
+			n++;
+		}
+		return n;
+	}
+
+	protected String keywordsToString(Grammar g) {
+		StringBuilder buf = new StringBuilder("[");
+		List<List<Grammar.Keyword>> groups = g.getKeywordsByLength();
+		for (int i = 0; i < groups.size(); i++) {
+			if ( i>0 ) {
+				buf.append(", ");
+			}
+			buf.append("[");
+			List<Grammar.Keyword> group = groups.get(i);
+			for (int j = 0; j < group.size(); j++) {
+				if ( j>0 ) {
+					buf.append(", ");
+				}
+				buf.append(group.get(j).text).append(":").append(group.get(j).rule);
+			}
+			buf.append("]");
+		}
+		return buf.append("]").toString();
+	}
+}